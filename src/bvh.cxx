@@ -0,0 +1,455 @@
+#include "bvh.hxx"
+
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+
+namespace res
+{
+	bool Aabb::is_empty() const
+	{
+		return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+	}
+
+	void Aabb::expand(const float x, const float y, const float z)
+	{
+		min[0] = std::min(min[0], x);
+		min[1] = std::min(min[1], y);
+		min[2] = std::min(min[2], z);
+		max[0] = std::max(max[0], x);
+		max[1] = std::max(max[1], y);
+		max[2] = std::max(max[2], z);
+	}
+
+	void Aabb::expand(const Aabb &other)
+	{
+		for (unsigned int i{0}; i < 3; ++i) {
+			min[i] = std::min(min[i], other.min[i]);
+			max[i] = std::max(max[i], other.max[i]);
+		}
+	}
+
+	float Aabb::surface_area() const
+	{
+		const float dx{max[0] - min[0]};
+		const float dy{max[1] - min[1]};
+		const float dz{max[2] - min[2]};
+		return 2 * (dx * dy + dy * dz + dz * dx);
+	}
+
+	bool Aabb::contains(const Aabb &other) const
+	{
+		for (unsigned int i{0}; i < 3; ++i) {
+			if (other.min[i] < min[i] || other.max[i] > max[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Aabb::overlaps(const Aabb &other) const
+	{
+		for (unsigned int i{0}; i < 3; ++i) {
+			if (other.max[i] < min[i] || other.min[i] > max[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	Aabb merge(const Aabb &a, const Aabb &b)
+	{
+		Aabb mod{a};
+		mod.expand(b);
+		return mod;
+	}
+
+	Aabb transform_aabb(const Aabb &bounds, const midnight::Matrix4x4 &transform)
+	{
+		if (bounds.is_empty()) {
+			return bounds;
+		}
+		Aabb mod;
+		for (unsigned int i{0}; i < 3; ++i) {
+			mod.min[i] = transform.entry(i, 3);
+			mod.max[i] = transform.entry(i, 3);
+			for (unsigned int j{0}; j < 3; ++j) {
+				const float a{transform.entry(i, j) * bounds.min[j]};
+				const float b{transform.entry(i, j) * bounds.max[j]};
+				mod.min[i] += std::min(a, b);
+				mod.max[i] += std::max(a, b);
+			}
+		}
+		return mod;
+	}
+
+	Frustum::Frustum(const midnight::Matrix4x4 &view_projection)
+	{
+		// Gribb-Hartmann plane extraction
+		for (unsigned int p{0}; p < 6; ++p) {
+			const unsigned int row{p / 2};
+			const float sign{p % 2 == 0 ? 1.0F : -1.0F};
+			for (unsigned int j{0}; j < 4; ++j) {
+				planes[p][j] = view_projection.entry(3, j) + sign * view_projection.entry(row, j);
+			}
+		}
+	}
+
+	bool Frustum::intersects(const Aabb &box) const
+	{
+		for (const auto &plane : planes) {
+			// corner furthest along the plane normal
+			const float x{plane[0] > 0 ? box.max[0] : box.min[0]};
+			const float y{plane[1] > 0 ? box.max[1] : box.min[1]};
+			const float z{plane[2] > 0 ? box.max[2] : box.min[2]};
+			if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Bvh::TreeNode::is_leaf() const
+	{
+		return left == null_proxy;
+	}
+
+	template<class F>
+	std::vector<Node*> Bvh::collect(F &&test) const
+	{
+		std::vector<Node*> found;
+		if (root == null_proxy) {
+			return found;
+		}
+		std::vector<unsigned int> stack{root};
+		while (!stack.empty()) {
+			const TreeNode &t{tree[stack.back()]};
+			stack.pop_back();
+			if (t.is_leaf()) {
+				if (test(t.tight)) {
+					found.push_back(t.node);
+				}
+			} else if (test(t.fat)) {
+				stack.push_back(t.left);
+				stack.push_back(t.right);
+			}
+		}
+		return found;
+	}
+
+	unsigned int Bvh::insert(const Aabb &bounds, Node *node)
+	{
+		const unsigned int leaf{allocate_tree_node()};
+		TreeNode &t{tree[leaf]};
+		t.tight = bounds;
+		t.fat = bounds;
+		for (unsigned int i{0}; i < 3; ++i) {
+			const float margin{std::max((bounds.max[i] - bounds.min[i]) * 0.1F, 0.01F)};
+			t.fat.min[i] -= margin;
+			t.fat.max[i] += margin;
+		}
+		t.node = node;
+		t.height = 0;
+		insert_leaf(leaf);
+		++proxy_count;
+		return leaf;
+	}
+
+	void Bvh::remove(const unsigned int proxy)
+	{
+		assert(proxy < tree.size() && tree[proxy].is_leaf());
+		remove_leaf(proxy);
+		free_tree_node(proxy);
+		--proxy_count;
+	}
+
+	bool Bvh::move(const unsigned int proxy, const Aabb &bounds)
+	{
+		assert(proxy < tree.size() && tree[proxy].is_leaf());
+		TreeNode &t{tree[proxy]};
+		t.tight = bounds;
+		if (t.fat.contains(bounds)) {
+			return false;
+		}
+		remove_leaf(proxy);
+		t.fat = bounds;
+		for (unsigned int i{0}; i < 3; ++i) {
+			const float margin{std::max((bounds.max[i] - bounds.min[i]) * 0.1F, 0.01F)};
+			t.fat.min[i] -= margin;
+			t.fat.max[i] += margin;
+		}
+		insert_leaf(proxy);
+		return true;
+	}
+
+	const Aabb &Bvh::get_bounds(const unsigned int proxy) const
+	{
+		return tree[proxy].tight;
+	}
+
+	std::size_t Bvh::get_proxy_count() const
+	{
+		return proxy_count;
+	}
+
+	std::vector<Node*> Bvh::query_aabb(const Aabb &bounds) const
+	{
+		return collect([&bounds](const Aabb &box) {
+			return box.overlaps(bounds);
+		});
+	}
+
+	std::vector<Node*> Bvh::query_sphere(const midnight::Vector3 centre, const float radius) const
+	{
+		const float c[3]{centre.entry(0, 0), centre.entry(1, 0), centre.entry(2, 0)};
+		const float radius_squared{radius * radius};
+		return collect([&c, radius_squared](const Aabb &box) {
+			float distance_squared{0.0F};
+			for (unsigned int i{0}; i < 3; ++i) {
+				const float d{std::max({box.min[i] - c[i], 0.0F, c[i] - box.max[i]})};
+				distance_squared += d * d;
+			}
+			return distance_squared <= radius_squared;
+		});
+	}
+
+	std::vector<Node*> Bvh::query_frustum(const midnight::Matrix4x4 &view_projection) const
+	{
+		const Frustum frustum{view_projection};
+		return collect([&frustum](const Aabb &box) {
+			return frustum.intersects(box);
+		});
+	}
+
+	std::optional<RayHit> Bvh::ray_cast(
+			const midnight::Vector3 origin,
+			const midnight::Vector3 direction,
+			const float max_distance
+			) const
+	{
+		const float direction_length{midnight::length(direction)};
+		if (root == null_proxy || direction_length == 0) {
+			return std::nullopt;
+		}
+		const float o[3]{origin.entry(0, 0), origin.entry(1, 0), origin.entry(2, 0)};
+		const float inverse[3]{
+			direction_length / direction.entry(0, 0),
+			direction_length / direction.entry(1, 0),
+			direction_length / direction.entry(2, 0)
+		};
+		// distance along the ray to where it enters the box, or nothing if it misses
+		const auto entry_distance{[&o, &inverse](const Aabb &box) -> std::optional<float> {
+			float near{0.0F};
+			float far{std::numeric_limits<float>::max()};
+			for (unsigned int i{0}; i < 3; ++i) {
+				const float t1{(box.min[i] - o[i]) * inverse[i]};
+				const float t2{(box.max[i] - o[i]) * inverse[i]};
+				near = std::max(near, std::min(t1, t2));
+				far = std::min(far, std::max(t1, t2));
+			}
+			if (near > far) {
+				return std::nullopt;
+			}
+			return near;
+		}};
+
+		// hits are against the leaves' bounding boxes, nearest first
+		std::optional<RayHit> hit;
+		float best{max_distance};
+		std::vector<unsigned int> stack{root};
+		while (!stack.empty()) {
+			const TreeNode &t{tree[stack.back()]};
+			stack.pop_back();
+			const std::optional<float> distance{entry_distance(t.is_leaf() ? t.tight : t.fat)};
+			if (!distance || *distance > best) {
+				continue;
+			}
+			if (t.is_leaf()) {
+				best = *distance;
+				hit = RayHit{t.node, *distance};
+			} else {
+				stack.push_back(t.left);
+				stack.push_back(t.right);
+			}
+		}
+		return hit;
+	}
+
+	unsigned int Bvh::allocate_tree_node()
+	{
+		if (free_list == null_proxy) {
+			tree.emplace_back();
+			return tree.size() - 1;
+		}
+		const unsigned int index{free_list};
+		free_list = tree[index].parent;
+		tree[index] = TreeNode{};
+		return index;
+	}
+
+	void Bvh::free_tree_node(const unsigned int index)
+	{
+		tree[index].parent = free_list;
+		tree[index].left = null_proxy;
+		tree[index].right = null_proxy;
+		tree[index].node = nullptr;
+		tree[index].height = -1;
+		free_list = index;
+	}
+
+	void Bvh::insert_leaf(const unsigned int leaf)
+	{
+		if (root == null_proxy) {
+			root = leaf;
+			tree[leaf].parent = null_proxy;
+			return;
+		}
+
+		// walk down picking the child that grows the least in surface area
+		const Aabb leaf_bounds{tree[leaf].fat};
+		unsigned int index{root};
+		while (!tree[index].is_leaf()) {
+			const TreeNode &t{tree[index]};
+			const float area{t.fat.surface_area()};
+			const float combined_area{merge(t.fat, leaf_bounds).surface_area()};
+			const float cost{2 * combined_area};
+			const float inheritance_cost{2 * (combined_area - area)};
+			const auto descend_cost{[&](const unsigned int child) {
+				const Aabb &c{tree[child].fat};
+				const float merged_area{merge(leaf_bounds, c).surface_area()};
+				if (tree[child].is_leaf()) {
+					return merged_area + inheritance_cost;
+				}
+				return merged_area - c.surface_area() + inheritance_cost;
+			}};
+			const float left_cost{descend_cost(t.left)};
+			const float right_cost{descend_cost(t.right)};
+			if (cost < left_cost && cost < right_cost) {
+				break;
+			}
+			index = left_cost < right_cost ? t.left : t.right;
+		}
+
+		const unsigned int sibling{index};
+		const unsigned int old_parent{tree[sibling].parent};
+		const unsigned int new_parent{allocate_tree_node()};
+		tree[new_parent].parent = old_parent;
+		tree[new_parent].fat = merge(leaf_bounds, tree[sibling].fat);
+		tree[new_parent].height = tree[sibling].height + 1;
+		tree[new_parent].left = sibling;
+		tree[new_parent].right = leaf;
+		tree[sibling].parent = new_parent;
+		tree[leaf].parent = new_parent;
+		if (old_parent != null_proxy) {
+			if (tree[old_parent].left == sibling) {
+				tree[old_parent].left = new_parent;
+			} else {
+				tree[old_parent].right = new_parent;
+			}
+		} else {
+			root = new_parent;
+		}
+
+		refit_upwards(tree[leaf].parent);
+	}
+
+	void Bvh::remove_leaf(const unsigned int leaf)
+	{
+		if (leaf == root) {
+			root = null_proxy;
+			return;
+		}
+
+		const unsigned int parent{tree[leaf].parent};
+		const unsigned int grand_parent{tree[parent].parent};
+		const unsigned int sibling{tree[parent].left == leaf ? tree[parent].right : tree[parent].left};
+		if (grand_parent != null_proxy) {
+			if (tree[grand_parent].left == parent) {
+				tree[grand_parent].left = sibling;
+			} else {
+				tree[grand_parent].right = sibling;
+			}
+			tree[sibling].parent = grand_parent;
+			free_tree_node(parent);
+			refit_upwards(grand_parent);
+		} else {
+			root = sibling;
+			tree[sibling].parent = null_proxy;
+			free_tree_node(parent);
+		}
+		tree[leaf].parent = null_proxy;
+	}
+
+	void Bvh::refit_upwards(unsigned int index)
+	{
+		while (index != null_proxy) {
+			index = balance(index);
+			TreeNode &t{tree[index]};
+			t.height = 1 + std::max(tree[t.left].height, tree[t.right].height);
+			t.fat = merge(tree[t.left].fat, tree[t.right].fat);
+			index = t.parent;
+		}
+	}
+
+	unsigned int Bvh::balance(const unsigned int a_index)
+	{
+		TreeNode &a{tree[a_index]};
+		if (a.is_leaf() || a.height < 2) {
+			return a_index;
+		}
+
+		const unsigned int b_index{a.left};
+		const unsigned int c_index{a.right};
+		TreeNode &b{tree[b_index]};
+		TreeNode &c{tree[c_index]};
+		const int difference{c.height - b.height};
+
+		// promote whichever child is too tall, and hand its shorter child down to a
+		const auto rotate{[&](TreeNode &up, const unsigned int up_index, TreeNode &other, const bool up_was_right) {
+			const unsigned int f_index{up.left};
+			const unsigned int g_index{up.right};
+			TreeNode &f{tree[f_index]};
+			TreeNode &g{tree[g_index]};
+
+			up.left = a_index;
+			up.parent = a.parent;
+			a.parent = up_index;
+			if (up.parent != null_proxy) {
+				if (tree[up.parent].left == a_index) {
+					tree[up.parent].left = up_index;
+				} else {
+					tree[up.parent].right = up_index;
+				}
+			} else {
+				root = up_index;
+			}
+
+			const bool keep_f{f.height > g.height};
+			const unsigned int kept_index{keep_f ? f_index : g_index};
+			const unsigned int given_index{keep_f ? g_index : f_index};
+			TreeNode &kept{tree[kept_index]};
+			TreeNode &given{tree[given_index]};
+			up.right = kept_index;
+			if (up_was_right) {
+				a.right = given_index;
+			} else {
+				a.left = given_index;
+			}
+			given.parent = a_index;
+			a.fat = merge(other.fat, given.fat);
+			up.fat = merge(a.fat, kept.fat);
+			a.height = 1 + std::max(other.height, given.height);
+			up.height = 1 + std::max(a.height, kept.height);
+		}};
+
+		if (difference > 1) {
+			rotate(c, c_index, b, true);
+			return c_index;
+		}
+		if (difference < -1) {
+			rotate(b, b_index, c, false);
+			return b_index;
+		}
+		return a_index;
+	}
+}
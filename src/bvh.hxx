@@ -0,0 +1,112 @@
+#ifndef RES_BVH
+#define RES_BVH
+
+#include <vector>
+#include <optional>
+#include <limits>
+#include <midnight.hxx>
+
+namespace res
+{
+	class Node;
+
+	struct Aabb final
+	{
+		float min[3]{
+			std::numeric_limits<float>::max(),
+			std::numeric_limits<float>::max(),
+			std::numeric_limits<float>::max()
+		};
+		float max[3]{
+			std::numeric_limits<float>::lowest(),
+			std::numeric_limits<float>::lowest(),
+			std::numeric_limits<float>::lowest()
+		};
+
+		bool is_empty() const;
+		void expand(const float x, const float y, const float z);
+		void expand(const Aabb &other);
+		float surface_area() const;
+		bool contains(const Aabb &other) const;
+		bool overlaps(const Aabb &other) const;
+	};
+
+	Aabb merge(const Aabb &a, const Aabb &b);
+	// Bounds of the box after transforming it, these are conservative for rotations.
+	Aabb transform_aabb(const Aabb &bounds, const midnight::Matrix4x4 &transform);
+
+	// Planes of the frustum described by projection * view. A default frustum has no planes and
+	// intersects everything.
+	struct Frustum final
+	{
+		// pointing into the frustum
+		float planes[6][4]{};
+
+		Frustum() = default;
+		explicit Frustum(const midnight::Matrix4x4 &view_projection);
+
+		bool intersects(const Aabb &box) const;
+	};
+
+	struct RayHit final
+	{
+		Node *node{nullptr};
+		float distance{0.0F};
+	};
+
+	// Dynamic AABB tree. Leaves keep a fattened box so that small movements don't touch the tree,
+	// and the tree is kept balanced with AVL style rotations as leaves are inserted and removed.
+	class Bvh final
+	{
+	public:
+		static constexpr unsigned int null_proxy{std::numeric_limits<unsigned int>::max()};
+
+		unsigned int insert(const Aabb &bounds, Node *node);
+		void remove(const unsigned int proxy);
+		// Returns true if the leaf had to be reinserted.
+		bool move(const unsigned int proxy, const Aabb &bounds);
+		const Aabb &get_bounds(const unsigned int proxy) const;
+		std::size_t get_proxy_count() const;
+
+		std::vector<Node*> query_aabb(const Aabb &bounds) const;
+		std::vector<Node*> query_sphere(const midnight::Vector3 centre, const float radius) const;
+		// Takes projection * view, anything intersecting the frustum it describes is returned.
+		std::vector<Node*> query_frustum(const midnight::Matrix4x4 &view_projection) const;
+		std::optional<RayHit> ray_cast(
+				const midnight::Vector3 origin,
+				const midnight::Vector3 direction,
+				const float max_distance = std::numeric_limits<float>::max()
+				) const;
+
+	private:
+		struct TreeNode
+		{
+			Aabb fat;
+			Aabb tight;
+			Node *node{nullptr};
+			unsigned int parent{null_proxy};
+			unsigned int left{null_proxy};
+			unsigned int right{null_proxy};
+			// leaves are 0, free nodes are -1
+			int height{-1};
+
+			bool is_leaf() const;
+		};
+
+		std::vector<TreeNode> tree;
+		unsigned int root{null_proxy};
+		unsigned int free_list{null_proxy};
+		std::size_t proxy_count{0};
+
+		unsigned int allocate_tree_node();
+		void free_tree_node(const unsigned int index);
+		void insert_leaf(const unsigned int leaf);
+		void remove_leaf(const unsigned int leaf);
+		unsigned int balance(const unsigned int index);
+		void refit_upwards(unsigned int index);
+		template<class F>
+		std::vector<Node*> collect(F &&test) const;
+	};
+}
+
+#endif
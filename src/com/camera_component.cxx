@@ -6,14 +6,6 @@
 
 namespace res
 {
-	void Camera::cycle(const midnight::Matrix4x4 current_transform) 
-	{
-		Scene *owning_scene{owning_node->get_owning_scene()};
-		if (owning_scene->get_active_camera() == this) {
-			owning_scene->view_matrix = (current_transform * owning_node->get_transform()).inverse();
-		}
-	}
-
 	void Camera::set_active()
 	{
 		Scene *owning_scene{owning_node->get_owning_scene()};
@@ -65,6 +57,12 @@ namespace res
 		return far;
 	}
 
+	void Camera::update_scene_view_matrix()
+	{
+		Scene *owning_scene{owning_node->get_owning_scene()};
+		owning_scene->view_matrix = (owning_node->get_current_transform() * owning_node->get_transform()).inverse();
+	}
+
 	void Camera::update_scene_projection_matrix()
 	{
 		Scene *owning_scene{owning_node->get_owning_scene()};
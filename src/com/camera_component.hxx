@@ -9,8 +9,6 @@ namespace res
 	class Camera : public Component
 	{
 	public:
-		virtual void cycle(const midnight::Matrix4x4 current_transform) override;
-		
 		void set_active();
 		void set_fov(const float fov);
 		float get_fov() const;
@@ -27,6 +25,11 @@ namespace res
 		float near{0.001}, far{2000.0};
 
 		void update_scene_projection_matrix();
+		// Run by the scene before the rest of the cycle, so that everything recorded in a snapshot
+		// sees the same view.
+		void update_scene_view_matrix();
+
+		friend class Scene;
 	};
 }
 
@@ -7,6 +7,23 @@
 namespace res
 {
 	class Node;
+	class Component;
+
+	template<class T>
+	concept ComponentType = std::is_base_of<Component, T>::value;
+	// inline rather than static so that the whole program shares one counter and one id per type,
+	// the ids index Scene's component pools
+	inline unsigned int unique_component_id()
+	{
+		static unsigned int id{0};
+		return id++;
+	}
+	template<ComponentType T>
+	inline unsigned int component_id()
+	{
+		static unsigned int id{unique_component_id()};
+		return id;
+	}
 
 	class Component
 	{
@@ -21,7 +38,13 @@ namespace res
 	protected:
 		Node *owning_node;
 
+	private:
+		// set by the owning node, which keeps its components in a list through next_component
+		unsigned int type_id{0};
+		Component *next_component{nullptr};
+
 		friend class Node;
+		friend class Scene;
 	};
 }
 
@@ -2,51 +2,64 @@
 
 #include <iostream>
 #include <vector>
-#include <glbinding/gl/gl.h>
 #include <midnight.hxx>
 #include <node.hxx>
 #include <scene.hxx>
 
 namespace res
 {
+	Drawable::~Drawable()
+	{
+		if (proxy != Bvh::null_proxy) {
+			owning_node->get_owning_scene()->bvh.remove(proxy);
+		}
+	}
+
 	void Drawable::set_shader(const unsigned int shader)
 	{
 		this->shader = shader;
 	}
 
-	void Drawable::set_model(std::weak_ptr<res::ModelResource> model)
+	void Drawable::set_model(res::ResourceController<res::ModelResource> &controller, const res::ResourceHandle<res::ModelResource> model)
 	{
-		this->model = model;
+		this->controller = &controller;
+		model_handle = model;
+		this->model = controller.retrieve(model);
+		model_bounds = this->model.lock()->get_bounds();
 	}
 
 	void Drawable::cycle(const midnight::Matrix4x4 current_transform)
 	{
-		if (std::shared_ptr<res::ModelResource> locked_model{model.lock()}) {
-			if (shader != 0) {
-				const std::vector<res::ModelResource::Mesh> &meshes{locked_model->get_meshes()};
-				for (auto &mesh : meshes) {
-					gl::glUseProgram(shader);
-
-					const int model_loc{gl::glGetUniformLocation(shader, "u_model")};
-					const int view_loc{gl::glGetUniformLocation(shader, "u_view")};
-					const int projection_loc{gl::glGetUniformLocation(shader, "u_projection")};
-					Scene *owning_scene{owning_node->get_owning_scene()};
-					midnight::Matrix4x4 v{owning_scene->view_matrix};
-					midnight::Matrix4x4 p{owning_scene->projection_matrix};
-					midnight::Matrix4x4 transform{owning_node->get_main_transform() * current_transform * owning_node->get_priority_transform()};
-					gl::glUniformMatrix4fv(model_loc, 1, false, transform.dataPtr());
-					gl::glUniformMatrix4fv(view_loc, 1, false, v.dataPtr());
-					gl::glUniformMatrix4fv(projection_loc, 1, false, p.dataPtr());
+		Scene *owning_scene{owning_node->get_owning_scene()};
+		const midnight::Matrix4x4 transform{owning_node->get_main_transform() * current_transform * owning_node->get_priority_transform()};
+		std::shared_ptr<res::ModelResource> locked{model.lock()};
+		if (locked && !locked->get_bounds().is_empty()) {
+			model_bounds = locked->get_bounds();
+		}
+		const Aabb bounds{transform_aabb(model_bounds, transform)};
+		if (locked && !bounds.is_empty()) {
+			if (proxy == Bvh::null_proxy) {
+				proxy = owning_scene->bvh.insert(bounds, owning_node);
+			} else {
+				owning_scene->bvh.move(proxy, bounds);
+			}
+		} else if (proxy != Bvh::null_proxy) {
+			owning_scene->bvh.remove(proxy);
+			proxy = Bvh::null_proxy;
+		}
 
-					gl::glBindVertexArray(mesh.get_vao());
-					gl::glDrawElements(
-							gl::GL_TRIANGLES,
-							mesh.get_index_count(),
-							gl::GL_UNSIGNED_INT,
-							reinterpret_cast<void*>(0)
-							);
-					gl::glBindVertexArray(0);
+		if (locked) {
+			if (shader != 0 && owning_scene->view_frustum.intersects(bounds)) {
+				RenderSnapshot &snapshot{owning_scene->get_update_snapshot()};
+				for (const res::ModelResource::Mesh &mesh : locked->get_meshes()) {
+					DrawPacket &packet{snapshot.packets.emplace_back()};
+					packet.shader = shader;
+					packet.vao = mesh.get_vao();
+					packet.index_count = mesh.get_index_count();
+					packet.index_type = mesh.get_index_type();
+					packet.model = transform;
 				}
+				snapshot.models.push_back({controller, model_handle, std::move(locked)});
 			}
 		} else {
 			std::cerr << "Node, model or shader unset.\n";
@@ -3,21 +3,32 @@
 
 #include <memory>
 #include <component.hxx>
+#include <resource.hxx>
 #include <model_resource.hxx>
+#include <bvh.hxx>
 
 namespace res
 {
 	class Drawable : public Component
 	{
 	public:
+		~Drawable();
+
 		virtual void cycle(const midnight::Matrix4x4 current_transform) override;
 		
 		void set_shader(const unsigned int shader);
-		void set_model(std::weak_ptr<res::ModelResource> model);
+		// The model is only locked by the snapshots that draw it, while it is in view, and retrieved
+		// from controller again for each of them. controller has to outlive the drawable.
+		void set_model(res::ResourceController<res::ModelResource> &controller, const res::ResourceHandle<res::ModelResource> model);
 	
 	protected:
+		res::ResourceController<res::ModelResource> *controller{nullptr};
+		res::ResourceHandle<res::ModelResource> model_handle;
 		std::weak_ptr<res::ModelResource> model;
+		// as last loaded, so that the drawable is still placed and culled while its model is evicted
+		Aabb model_bounds;
 		unsigned int shader{0};
+		unsigned int proxy{Bvh::null_proxy};
 	};
 }
 
@@ -0,0 +1,137 @@
+#include "water_component.hxx"
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <iostream>
+#include <midnight.hxx>
+#include <node.hxx>
+#include <scene.hxx>
+#include <procedural.hxx>
+
+namespace res
+{
+	namespace
+	{
+		enum Patch
+		{
+			block,
+			ring,
+			column_trim,
+			row_trim
+		};
+	}
+
+	void Water::cycle(const midnight::Matrix4x4 current_transform)
+	{
+		if (patches.empty()) {
+			std::cerr << "Water, shader unset.\n";
+			return;
+		}
+
+		Scene *owning_scene{owning_node->get_owning_scene()};
+		const midnight::Matrix4x4 camera_transform{owning_scene->view_matrix.inverse()};
+		const float camera_x{camera_transform.entry(0, 3)};
+		const float camera_z{camera_transform.entry(2, 3)};
+		const midnight::Matrix4x4 transform{owning_node->get_main_transform() * current_transform * owning_node->get_priority_transform()};
+		const float sea_level{transform.entry(1, 3)};
+
+		std::vector<DrawPacket> &packets{owning_scene->get_update_snapshot().packets};
+		const auto draw{[&](const Patch patch, const float x, const float z, const float scale, const float parameters[4]) {
+			const ModelResource::Mesh &mesh{patches[patch]};
+			DrawPacket &packet{packets.emplace_back()};
+			packet.shader = shader;
+			packet.vao = mesh.get_vao();
+			packet.index_count = mesh.get_index_count();
+			packet.index_type = mesh.get_index_type();
+			packet.model = midnight::Matrix4x4{
+				scale, 0, 0, x,
+				0, 1, 0, sea_level,
+				0, 0, scale, z,
+				0, 0, 0, 1
+			};
+			std::copy_n(parameters, 4, packet.parameters);
+		}};
+
+		// every level is centred on its own grid of twice its cell size, which puts the level inside
+		// it either on the centre or one cell off, the trims fill whichever side that leaves open
+		const unsigned int quarter{grid_size / 4};
+		float inner_x{0.0F}, inner_z{0.0F};
+		for (unsigned int l{0}; l < levels; ++l) {
+			const float scale{cell_size * static_cast<float>(1U << l)};
+			const float centre_x{std::floor(camera_x / (2 * scale)) * 2 * scale};
+			const float centre_z{std::floor(camera_z / (2 * scale)) * 2 * scale};
+			const float corner_x{centre_x - grid_size / 2 * scale};
+			const float corner_z{centre_z - grid_size / 2 * scale};
+			const float parameters[4]{centre_x, centre_z, grid_size / 2 * scale, time};
+			if (l == 0) {
+				draw(block, corner_x, corner_z, scale, parameters);
+			} else {
+				draw(ring, corner_x, corner_z, scale, parameters);
+				const bool shifted_x{inner_x > centre_x};
+				const bool shifted_z{inner_z > centre_z};
+				draw(
+						column_trim,
+						corner_x + (shifted_x ? quarter : 3 * quarter) * scale,
+						corner_z + quarter * scale,
+						scale,
+						parameters
+						);
+				draw(
+						row_trim,
+						corner_x + (quarter + (shifted_x ? 1 : 0)) * scale,
+						corner_z + (shifted_z ? quarter : 3 * quarter) * scale,
+						scale,
+						parameters
+						);
+			}
+			inner_x = centre_x;
+			inner_z = centre_z;
+		}
+	}
+
+	void Water::set_shader(const unsigned int shader)
+	{
+		this->shader = shader;
+		if (patches.empty()) {
+			build_patches();
+		}
+	}
+
+	void Water::set_time(const float time)
+	{
+		this->time = time;
+	}
+
+	void Water::set_levels(const unsigned int levels)
+	{
+		assert(levels > 0);
+		this->levels = levels;
+	}
+
+	void Water::set_grid_size(const unsigned int grid_size)
+	{
+		assert(grid_size > 0 && grid_size % 4 == 0);
+		this->grid_size = grid_size;
+		if (!patches.empty()) {
+			build_patches();
+		}
+	}
+
+	void Water::set_cell_size(const float cell_size)
+	{
+		assert(cell_size > 0);
+		this->cell_size = cell_size;
+	}
+
+	void Water::build_patches()
+	{
+		const unsigned int quarter{grid_size / 4};
+		patches.clear();
+		patches.reserve(4);
+		patches.push_back(grid_mesh(grid_size, grid_size, 1.0F));
+		patches.push_back(grid_mesh(grid_size, grid_size, 1.0F, quarter, 3 * quarter + 1));
+		patches.push_back(grid_mesh(1, 2 * quarter + 1, 1.0F));
+		patches.push_back(grid_mesh(2 * quarter, 1, 1.0F));
+	}
+}
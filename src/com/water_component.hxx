@@ -0,0 +1,39 @@
+#ifndef RES_WATER_COMPONENT
+#define RES_WATER_COMPONENT
+
+#include <vector>
+#include <component.hxx>
+#include <model_resource.hxx>
+
+namespace res
+{
+	// Sea surface drawn as nested grids centred on the active camera (a geometry clipmap). The
+	// grids are built once and every level doubles the cell size of the one inside it, so the
+	// vertex count is fixed however far the view reaches. Waves are computed in the vertex shader.
+	// The grids are GL objects, so they are built by set_shader and set_grid_size on the GL thread.
+	class Water : public Component
+	{
+	public:
+		virtual void cycle(const midnight::Matrix4x4 current_transform) override;
+
+		void set_shader(const unsigned int shader);
+		void set_time(const float time);
+		void set_levels(const unsigned int levels);
+		void set_grid_size(const unsigned int grid_size);
+		void set_cell_size(const float cell_size);
+
+	private:
+		unsigned int shader{0};
+		float time{0.0F};
+		unsigned int levels{7};
+		// cells along each side of a level, must be a multiple of 4
+		unsigned int grid_size{64};
+		float cell_size{1.0F};
+		// the centre block, a ring, and the column and row that trim a ring's hole to fit the level inside it
+		std::vector<ModelResource::Mesh> patches;
+
+		void build_patches();
+	};
+}
+
+#endif
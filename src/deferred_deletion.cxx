@@ -0,0 +1,60 @@
+#include "deferred_deletion.hxx"
+
+#include <mutex>
+#include <vector>
+#include <glbinding/gl/gl.h>
+
+namespace res
+{
+	namespace
+	{
+		struct PendingDeletion
+		{
+			unsigned long swap;
+			bool vertex_array;
+			unsigned int name;
+		};
+
+		std::mutex pending_mutex;
+		std::vector<PendingDeletion> pending;
+		unsigned long swap_count{0};
+
+		void defer(const bool vertex_array, const unsigned int name)
+		{
+			// 0 is what moved-from meshes are left with
+			if (name == 0) {
+				return;
+			}
+			const std::lock_guard lock{pending_mutex};
+			pending.push_back({swap_count, vertex_array, name});
+		}
+	}
+
+	void defer_buffer_deletion(const unsigned int buffer)
+	{
+		defer(false, buffer);
+	}
+
+	void defer_vertex_array_deletion(const unsigned int vertex_array)
+	{
+		defer(true, vertex_array);
+	}
+
+	void collect_deferred_deletions()
+	{
+		const std::lock_guard lock{pending_mutex};
+		++swap_count;
+		// the snapshot recorded before the first of those swaps is rendered before the second
+		std::erase_if(pending, [](const PendingDeletion &deletion) {
+			if (deletion.swap + 2 > swap_count) {
+				return false;
+			}
+			if (deletion.vertex_array) {
+				gl::glDeleteVertexArrays(1, &deletion.name);
+			} else {
+				gl::glDeleteBuffers(1, &deletion.name);
+			}
+			return true;
+		});
+	}
+}
@@ -0,0 +1,18 @@
+#ifndef RES_DEFERRED_DELETION
+#define RES_DEFERRED_DELETION
+
+namespace res
+{
+	// Draw packets name GL objects and are rendered a frame after they are recorded, so objects
+	// destroyed in the meantime are only queued here. They are deleted once every snapshot that
+	// could still name them has been rendered, which is two swaps after they were queued.
+	//
+	// Queuing is safe from any thread. Collecting must happen on the GL thread, and the swap
+	// count assumes a single scene is swapped per frame.
+	void defer_buffer_deletion(const unsigned int buffer);
+	void defer_vertex_array_deletion(const unsigned int vertex_array);
+	// Called by Scene::swap_snapshots.
+	void collect_deferred_deletions();
+}
+
+#endif
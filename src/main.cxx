@@ -5,6 +5,8 @@
 #include <ios>
 #include <chrono>
 #include <thread>
+#include <semaphore>
+#include <stop_token>
 #include <vector>
 #include <array>
 #include <numbers>
@@ -21,6 +23,7 @@
 #include <component.hxx>
 #include <drawable_component.hxx>
 #include <camera_component.hxx>
+#include <water_component.hxx>
 #include <text_resource.hxx>
 #include <model_resource.hxx>
 
@@ -54,11 +57,12 @@ int main()
 
 	{
 		res::ResourceController<res::TextResource> rc;
-		rc.index("s_vertex", "../src/shaders/vertex.glsl");
-		rc.index("s_fragment", "../src/shaders/fragment.glsl");
-		rc.index("s_water_fragment", "../src/shaders/water_fragment.glsl");
-		const char *vertex_source{rc.retrieve("s_vertex").lock()->get_text()};
-		const char *fragment_source{rc.retrieve("s_fragment").lock()->get_text()};
+		const res::ResourceHandle<res::TextResource> s_vertex{rc.index("s_vertex", "../src/shaders/vertex.glsl")};
+		const res::ResourceHandle<res::TextResource> s_fragment{rc.index("s_fragment", "../src/shaders/fragment.glsl")};
+		const res::ResourceHandle<res::TextResource> s_water_vertex{rc.index("s_water_vertex", "../src/shaders/water_vertex.glsl")};
+		const res::ResourceHandle<res::TextResource> s_water_fragment{rc.index("s_water_fragment", "../src/shaders/water_fragment.glsl")};
+		const char *vertex_source{rc.retrieve(s_vertex).lock()->get_text()};
+		const char *fragment_source{rc.retrieve(s_fragment).lock()->get_text()};
 		unsigned int program{gl::glCreateProgram()};
 		unsigned int vertex_shader{gl::glCreateShader(gl::GL_VERTEX_SHADER)};
 		unsigned int fragment_shader{gl::glCreateShader(gl::GL_FRAGMENT_SHADER)};
@@ -70,15 +74,20 @@ int main()
 		gl::glAttachShader(program, fragment_shader);
 		gl::glLinkProgram(program);
 		unsigned int water_program{gl::glCreateProgram()};
-		const char *water_fragment_source{rc.retrieve("s_water_fragment").lock()->get_text()};
+		const char *water_vertex_source{rc.retrieve(s_water_vertex).lock()->get_text()};
+		const char *water_fragment_source{rc.retrieve(s_water_fragment).lock()->get_text()};
+		unsigned int water_vertex_shader{gl::glCreateShader(gl::GL_VERTEX_SHADER)};
 		unsigned int water_fragment_shader{gl::glCreateShader(gl::GL_FRAGMENT_SHADER)};
+		gl::glShaderSource(water_vertex_shader, 1, &water_vertex_source, NULL);
+		gl::glCompileShader(water_vertex_shader);
 		gl::glShaderSource(water_fragment_shader, 1, &water_fragment_source, NULL);
 		gl::glCompileShader(water_fragment_shader);
-		gl::glAttachShader(water_program, vertex_shader);
+		gl::glAttachShader(water_program, water_vertex_shader);
 		gl::glAttachShader(water_program, water_fragment_shader);
 		gl::glLinkProgram(water_program);
 		gl::glDeleteShader(vertex_shader);
 		gl::glDeleteShader(fragment_shader);
+		gl::glDeleteShader(water_vertex_shader);
 		gl::glDeleteShader(water_fragment_shader);
 
 		gl::glUseProgram(program);
@@ -87,6 +96,12 @@ int main()
 		midnight::Matrix4x4 v{midnight::matrixIdentity<4>()};
 		midnight::Matrix4x4 p{midnight::matrixPerspective(0.57, default_win_w / default_win_h, 0.001F, 2000)};
 
+		// declared first so that it outlives the scene's drawables and snapshots
+		res::ResourceController<res::ModelResource> mc;
+		const res::ResourceHandle<res::ModelResource> m_boat{mc.index("m_boat", "boat.obj")};
+		const res::ResourceHandle<res::ModelResource> m_ags{mc.index("m_ags", "ags.obj")};
+		const res::ResourceHandle<res::ModelResource> m_hollow{mc.index("m_hollow", "hollow.obj")};
+
 		res::Scene main_scene;
 
 		res::Node *hull{main_scene.get_root()->add_child()}, *rear_turret{hull->add_child()}, *forward_turret{hull->add_child()};
@@ -97,19 +112,19 @@ int main()
 		rear_turret->get_component<res::Drawable>()->set_shader(program);
 		forward_turret->get_component<res::Drawable>()->set_shader(program);
 
+		res::Node *sea{main_scene.get_root()->add_child()};
+		sea->add_component<res::Water>();
+		sea->get_component<res::Water>()->set_shader(water_program);
+		sea->set_main_transform(midnight::matrixTranslation(midnight::Vector3{0, -0.1, 0}));
+
 		res::Node *camera{main_scene.get_root()->add_child()};
 		camera->add_component<res::Camera>();
 		camera->get_component<res::Camera>()->set_active();
 		camera->get_component<res::Camera>()->set_fov(2);
 		
-		res::ResourceController<res::ModelResource> mc;
-		mc.index("m_boat", "boat.obj");
-		mc.index("m_ags", "ags.obj");
-		mc.index("m_hollow", "hollow.obj");
-		hull->get_component<res::Drawable>()->set_model(mc.retrieve("m_boat"));
-		hull->get_component<res::Drawable>()->set_model(mc.retrieve("m_boat"));
-		rear_turret->get_component<res::Drawable>()->set_model(mc.retrieve("m_ags"));
-		forward_turret->get_component<res::Drawable>()->set_model(mc.retrieve("m_ags"));
+		hull->get_component<res::Drawable>()->set_model(mc, m_boat);
+		rear_turret->get_component<res::Drawable>()->set_model(mc, m_ags);
+		forward_turret->get_component<res::Drawable>()->set_model(mc, m_ags);
 		
 		hull->set_main_transform(m);
 		rear_turret->set_priority_transform(midnight::matrixRotation(midnight::Vector3{0, 1, 0}, std::numbers::pi_v<float> / -4));
@@ -117,6 +132,26 @@ int main()
 		rear_turret->set_main_transform(midnight::matrixTranslation(midnight::Vector3{-0.61, 0.15, 0}));
 		forward_turret->set_main_transform(midnight::matrixTranslation(midnight::Vector3{-1.15, 0.15, 0}));
 
+		main_scene.cycle();
+		main_scene.swap_snapshots();
+
+		// the next frame updates on this thread while the current one is submitted, it is woken
+		// once per frame rather than started anew
+		std::binary_semaphore update_start{0}, update_done{0};
+		std::jthread updater{[&main_scene, &update_start, &update_done](const std::stop_token stop) {
+			const std::stop_callback wake{stop, [&update_start] {
+				update_start.release();
+			}};
+			while (true) {
+				update_start.acquire();
+				if (stop.stop_requested()) {
+					return;
+				}
+				main_scene.cycle();
+				update_done.release();
+			}
+		}};
+
 		while (!glfwWindowShouldClose(mw)) {
 			gl::glClear(gl::GL_COLOR_BUFFER_BIT | gl::GL_DEPTH_BUFFER_BIT);
 
@@ -132,9 +167,13 @@ int main()
 
 			const float t{static_cast<const float>(glfwGetTime())};
 			midnight::Vector3 dir{midnight::cartesian3({1, std::sin(t), std::sin(t)})};
-			gl::glUniform3fv(gl::glGetUniformLocation(program, "u_light_dir"), 1, dir.dataPtr());
+			main_scene.set_light_direction(dir);
+			sea->get_component<res::Water>()->set_time(t);
 			
-			main_scene.cycle();
+			update_start.release();
+			main_scene.render();
+			update_done.acquire();
+			main_scene.swap_snapshots();
 			// rear_turret->transform_priority(midnight::matrixRotation(midnight::Vector3{0, 1, 0}, 0.1));
 			// hull->transform_priority(midnight::matrixRotation(midnight::Vector3{0, 1, 0}, 0.1));
 
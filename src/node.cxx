@@ -9,9 +9,32 @@ namespace res
 {
 	Node *Node::add_child()
 	{
-		children.push_back(new Node);
-		children.back()->owning_scene = owning_scene;
-		return children.back();
+		Node *const child{owning_scene->node_pool.allocate()};
+		child->owning_scene = owning_scene;
+		child->parent = this;
+		child->next_sibling = first_child;
+		if (first_child != nullptr) {
+			first_child->previous_sibling = child;
+		}
+		first_child = child;
+		return child;
+	}
+
+	void Node::remove_child(Node *child)
+	{
+		if (child->parent != this) {
+			std::cerr << "Node, attempted to remove a node that isn't a child.\n";
+			return;
+		}
+		if (child->previous_sibling != nullptr) {
+			child->previous_sibling->next_sibling = child->next_sibling;
+		} else {
+			first_child = child->next_sibling;
+		}
+		if (child->next_sibling != nullptr) {
+			child->next_sibling->previous_sibling = child->previous_sibling;
+		}
+		owning_scene->release_node(child);
 	}
 
 	midnight::Matrix4x4 Node::get_transform() const
@@ -54,13 +77,39 @@ namespace res
 		return owning_scene;
 	}
 
+	midnight::Matrix4x4 Node::get_current_transform() const
+	{
+		if (parent == nullptr) {
+			return midnight::matrixIdentity<4>();
+		}
+		return parent->main_transform * parent->get_current_transform() * parent->priority_transform;
+	}
+
 	void Node::cycle(const midnight::Matrix4x4 current_transform)
 	{
-		for (auto component : components) {
-			component.second->cycle(current_transform);
+		for (Component *component{first_component}; component != nullptr; component = component->next_component) {
+			component->cycle(current_transform);
 		}
-		for (auto child : children) {
+		for (Node *child{first_child}; child != nullptr; child = child->next_sibling) {
 			child->cycle(main_transform * current_transform * priority_transform);
 		}
 	}
+
+	Component *Node::find_component(const unsigned int id) const
+	{
+		Component *component{first_component};
+		while (component != nullptr && component->type_id != id) {
+			component = component->next_component;
+		}
+		return component;
+	}
+
+	void Node::unlink_component(Component *component)
+	{
+		Component **link{&first_component};
+		while (*link != component) {
+			link = &(*link)->next_component;
+		}
+		*link = component->next_component;
+	}
 }
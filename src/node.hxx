@@ -1,37 +1,21 @@
 #ifndef RES_NODE
 #define RES_NODE
 
-#include <vector>
-#include <unordered_map>
 #include <iostream>
 #include <midnight.hxx>
 #include <component.hxx>
+#include <pool.hxx>
+#include <scene.hxx>
 
 namespace res
 {
-	class Scene;
-	class Component;
-
-	template<class T>
-	concept ComponentType = std::is_base_of<Component, T>::value;
-	static inline unsigned int unique_component_id()
-	{
-		static unsigned int id{0};
-		return id++;
-	}
-	template<ComponentType T>
-	static unsigned int component_id()
-	{
-		static unsigned int id{unique_component_id()};
-		return id;
-	}
-
 	class Node final
 	{
 	public:
 		void operator=(const Node &other) = delete;
 
 		Node *add_child();
+		void remove_child(Node *child);
 		midnight::Matrix4x4 get_transform() const;
 		void set_main_transform(const midnight::Matrix4x4 transform);
 		midnight::Matrix4x4 get_main_transform() const;
@@ -40,6 +24,8 @@ namespace res
 		void transform_main(const midnight::Matrix4x4 transform);
 		void transform_priority(const midnight::Matrix4x4 transform);
 		Scene *get_owning_scene() const;
+		// What cycle passes to this node's components, accumulated from its ancestors.
+		midnight::Matrix4x4 get_current_transform() const;
 
 		template<ComponentType T>
 		void add_component();
@@ -51,32 +37,47 @@ namespace res
 		Scene *owning_scene{nullptr};
 		midnight::Matrix4x4 main_transform{midnight::matrixIdentity<4>()};
 		midnight::Matrix4x4 priority_transform{midnight::matrixIdentity<4>()};
-		std::vector<Node*> children;
-		std::unordered_map<unsigned int, Component*> components;
+		// links are intrusive so that a pooled node never allocates, children are kept newest first
+		Node *parent{nullptr};
+		Node *first_child{nullptr};
+		Node *previous_sibling{nullptr};
+		Node *next_sibling{nullptr};
+		Component *first_component{nullptr};
 
 		Node() = default;
 		Node(const Node &other) = delete;
 
+		Component *find_component(const unsigned int id) const;
+		void unlink_component(Component *component);
+
 		friend class Scene;
+		template<class T, class B>
+		friend class Pool;
 	};
 
 	template<ComponentType T>
 	void Node::add_component()
 	{
-		if (components.contains(component_id<T>())) {
+		if (Component *const existing{find_component(component_id<T>())}) {
 			std::cerr << "Node, attempted to add a component that already exists.\n";
+			unlink_component(existing);
+			owning_scene->release_component(existing);
 		}
-		components[component_id<T>()] = new T();
-		components[component_id<T>()]->owning_node = this;
+		T *const component{owning_scene->allocate_component<T>()};
+		component->owning_node = this;
+		component->type_id = component_id<T>();
+		component->next_component = first_component;
+		first_component = component;
 	}
 
 	template<ComponentType T>
 	T *Node::get_component()
 	{
-		if (!components.contains(component_id<T>())) {
+		Component *const component{find_component(component_id<T>())};
+		if (component == nullptr) {
 			std::cerr << "Node, attempted to get a component that doesn't exist.\n";
 		}
-		return dynamic_cast<T*>(components.at(component_id<T>()));
+		return dynamic_cast<T*>(component);
 	}
 }
 
@@ -0,0 +1,54 @@
+#ifndef RES_POOL
+#define RES_POOL
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace res
+{
+	template<class B>
+	class PoolBase
+	{
+	public:
+		virtual ~PoolBase() = default;
+
+		virtual void release(B *object) = 0;
+	};
+
+	// Hands out fixed size slots carved from slabs. Released slots go on a free list and are reused
+	// before a new slab is made, and slabs are only returned all at once when the pool is destroyed,
+	// so objects must be released before that.
+	template<class T, class B = T>
+	class Pool final : public PoolBase<B>
+	{
+	public:
+		Pool() = default;
+		Pool(const Pool &other) = delete;
+
+		Pool &operator=(const Pool &other) = delete;
+
+		template<class... Args>
+		T *allocate(Args&&... args);
+		virtual void release(B *object) override;
+		std::size_t get_live_count() const;
+		std::size_t get_capacity() const;
+
+	private:
+		union Slot
+		{
+			Slot *next;
+			alignas(T) std::byte storage[sizeof(T)];
+		};
+
+		static constexpr std::size_t slab_size{256};
+
+		std::vector<std::unique_ptr<Slot[]>> slabs;
+		Slot *free_list{nullptr};
+		std::size_t live_count{0};
+	};
+}
+
+#include "pool.txx"
+
+#endif
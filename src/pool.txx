@@ -0,0 +1,49 @@
+#include "pool.hxx"
+
+#include <new>
+#include <utility>
+
+namespace res
+{
+	template<class T, class B>
+	template<class... Args>
+	T *Pool<T, B>::allocate(Args&&... args)
+	{
+		if (free_list == nullptr) {
+			slabs.push_back(std::make_unique_for_overwrite<Slot[]>(slab_size));
+			Slot *const slab{slabs.back().get()};
+			for (std::size_t i{0}; i < slab_size; ++i) {
+				slab[i].next = i + 1 < slab_size ? &slab[i + 1] : nullptr;
+			}
+			free_list = slab;
+		}
+		Slot *const slot{free_list};
+		free_list = slot->next;
+		T *const object{new (slot->storage) T(std::forward<Args>(args)...)};
+		++live_count;
+		return object;
+	}
+
+	template<class T, class B>
+	void Pool<T, B>::release(B *object)
+	{
+		T *const derived{static_cast<T*>(object)};
+		derived->~T();
+		Slot *const slot{reinterpret_cast<Slot*>(derived)};
+		slot->next = free_list;
+		free_list = slot;
+		--live_count;
+	}
+
+	template<class T, class B>
+	std::size_t Pool<T, B>::get_live_count() const
+	{
+		return live_count;
+	}
+
+	template<class T, class B>
+	std::size_t Pool<T, B>::get_capacity() const
+	{
+		return slabs.size() * slab_size;
+	}
+}
@@ -0,0 +1,284 @@
+#include "mesh_optimiser.hxx"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+
+namespace res
+{
+	namespace
+	{
+		constexpr unsigned int cache_size{32};
+		constexpr unsigned int simulated_cache_size{16};
+		constexpr float cache_decay_power{1.5F};
+		constexpr float last_triangle_score{0.75F};
+		constexpr float valence_boost_scale{2.0F};
+		constexpr float valence_boost_power{0.5F};
+		constexpr std::size_t no_triangle{std::numeric_limits<std::size_t>::max()};
+
+		float vertex_score(const int cache_position, const unsigned int live_triangles)
+		{
+			if (live_triangles == 0) {
+				return -1.0F;
+			}
+			float score{0.0F};
+			if (cache_position >= 0 && cache_position < 3) {
+				// the triangle that was just drawn, deliberately scored below the rest of the cache
+				score = last_triangle_score;
+			} else if (cache_position >= 3) {
+				const float scaler{1.0F / (cache_size - 3)};
+				score = std::pow(1.0F - (cache_position - 3) * scaler, cache_decay_power);
+			}
+			// favour vertices with few triangles left so they can leave the cache for good
+			score += valence_boost_scale * std::pow(static_cast<float>(live_triangles), -valence_boost_power);
+			return score;
+		}
+	}
+
+	void optimise_vertex_cache(std::vector<unsigned int> &indices, const unsigned int vertex_count)
+	{
+		const std::size_t triangle_count{indices.size() / 3};
+		if (triangle_count == 0) {
+			return;
+		}
+
+		// per vertex list of triangles that still have to be emitted, stored contiguously
+		std::vector<unsigned int> live_triangles(vertex_count, 0);
+		for (const unsigned int i : indices) {
+			++live_triangles[i];
+		}
+		std::vector<unsigned int> adjacency_offsets(vertex_count + 1, 0);
+		std::partial_sum(live_triangles.begin(), live_triangles.end(), adjacency_offsets.begin() + 1);
+		std::vector<unsigned int> adjacency(indices.size());
+		{
+			std::vector<unsigned int> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+			for (std::size_t i{0}; i < indices.size(); ++i) {
+				adjacency[fill[indices[i]]++] = i / 3;
+			}
+		}
+
+		std::vector<int> cache_positions(vertex_count, -1);
+		std::vector<float> vertex_scores(vertex_count);
+		for (unsigned int v{0}; v < vertex_count; ++v) {
+			vertex_scores[v] = vertex_score(-1, live_triangles[v]);
+		}
+		std::vector<float> triangle_scores(triangle_count);
+		std::vector<bool> emitted(triangle_count, false);
+		std::size_t best{0};
+		for (std::size_t t{0}; t < triangle_count; ++t) {
+			triangle_scores[t] = vertex_scores[indices[t * 3]]
+				+ vertex_scores[indices[t * 3 + 1]]
+				+ vertex_scores[indices[t * 3 + 2]];
+			if (triangle_scores[t] > triangle_scores[best]) {
+				best = t;
+			}
+		}
+
+		std::vector<unsigned int> optimised;
+		optimised.reserve(indices.size());
+		std::vector<unsigned int> cache, next_cache;
+		cache.reserve(cache_size + 3);
+		next_cache.reserve(cache_size + 3);
+		std::size_t cursor{0};
+		for (std::size_t e{0}; e < triangle_count; ++e) {
+			if (best == no_triangle) {
+				// nothing in the cache has triangles left, restart at the next unemitted triangle
+				while (emitted[cursor]) {
+					++cursor;
+				}
+				best = cursor;
+			}
+			emitted[best] = true;
+			next_cache.clear();
+			for (unsigned int k{0}; k < 3; ++k) {
+				const unsigned int v{indices[best * 3 + k]};
+				optimised.push_back(v);
+				if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end()) {
+					next_cache.push_back(v);
+				}
+				unsigned int *const begin{adjacency.data() + adjacency_offsets[v]};
+				unsigned int *const end{begin + live_triangles[v]};
+				unsigned int *const found{std::find(begin, end, best)};
+				if (found != end) {
+					std::iter_swap(found, end - 1);
+					--live_triangles[v];
+				}
+			}
+			const std::size_t triangle_vertices{next_cache.size()};
+			for (const unsigned int v : cache) {
+				const auto triangle_end{next_cache.begin() + triangle_vertices};
+				if (std::find(next_cache.begin(), triangle_end, v) == triangle_end) {
+					next_cache.push_back(v);
+				}
+			}
+
+			for (std::size_t i{0}; i < next_cache.size(); ++i) {
+				const unsigned int v{next_cache[i]};
+				cache_positions[v] = i < cache_size ? static_cast<int>(i) : -1;
+				vertex_scores[v] = vertex_score(cache_positions[v], live_triangles[v]);
+			}
+			best = no_triangle;
+			float best_score{-1.0F};
+			for (const unsigned int v : next_cache) {
+				const unsigned int *const begin{adjacency.data() + adjacency_offsets[v]};
+				for (const unsigned int *t{begin}; t != begin + live_triangles[v]; ++t) {
+					const float score{vertex_scores[indices[*t * 3]]
+						+ vertex_scores[indices[*t * 3 + 1]]
+						+ vertex_scores[indices[*t * 3 + 2]]};
+					triangle_scores[*t] = score;
+					if (score > best_score) {
+						best_score = score;
+						best = *t;
+					}
+				}
+			}
+			if (next_cache.size() > cache_size) {
+				next_cache.resize(cache_size);
+			}
+			cache.swap(next_cache);
+		}
+		indices.swap(optimised);
+	}
+
+	void optimise_overdraw(std::vector<unsigned int> &indices, const std::vector<float> &vertices)
+	{
+		const std::size_t triangle_count{indices.size() / 3};
+		if (triangle_count == 0) {
+			return;
+		}
+
+		// a cluster starts wherever the simulated FIFO cache misses on all three vertices,
+		// so moving clusters around does not cost any extra vertex transforms
+		std::vector<std::size_t> cluster_starts;
+		{
+			std::vector<unsigned int> fifo(simulated_cache_size, std::numeric_limits<unsigned int>::max());
+			std::size_t head{0};
+			for (std::size_t t{0}; t < triangle_count; ++t) {
+				unsigned int misses{0};
+				for (unsigned int k{0}; k < 3; ++k) {
+					const unsigned int v{indices[t * 3 + k]};
+					if (std::find(fifo.begin(), fifo.end(), v) == fifo.end()) {
+						fifo[head] = v;
+						head = (head + 1) % simulated_cache_size;
+						++misses;
+					}
+				}
+				if (t == 0 || misses == 3) {
+					cluster_starts.push_back(t);
+				}
+			}
+		}
+		cluster_starts.push_back(triangle_count);
+		const std::size_t cluster_count{cluster_starts.size() - 1};
+		if (cluster_count < 2) {
+			return;
+		}
+
+		float mesh_centroid[3]{0.0F, 0.0F, 0.0F};
+		const std::size_t vertex_count{vertices.size() / 3};
+		for (std::size_t v{0}; v < vertex_count; ++v) {
+			for (unsigned int c{0}; c < 3; ++c) {
+				mesh_centroid[c] += vertices[v * 3 + c] / vertex_count;
+			}
+		}
+
+		// clusters whose area-weighted normal points away from the mesh centre are most likely
+		// to occlude the rest of the mesh, so they are drawn first
+		std::vector<float> cluster_keys(cluster_count);
+		for (std::size_t c{0}; c < cluster_count; ++c) {
+			float centroid[3]{0.0F, 0.0F, 0.0F};
+			float normal[3]{0.0F, 0.0F, 0.0F};
+			float area{0.0F};
+			for (std::size_t t{cluster_starts[c]}; t < cluster_starts[c + 1]; ++t) {
+				const float *const a{&vertices[indices[t * 3] * 3]};
+				const float *const b{&vertices[indices[t * 3 + 1] * 3]};
+				const float *const d{&vertices[indices[t * 3 + 2] * 3]};
+				const float e1[3]{b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+				const float e2[3]{d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+				const float n[3]{
+					e1[1] * e2[2] - e1[2] * e2[1],
+					e1[2] * e2[0] - e1[0] * e2[2],
+					e1[0] * e2[1] - e1[1] * e2[0]
+				};
+				const float triangle_area{std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2])};
+				for (unsigned int k{0}; k < 3; ++k) {
+					centroid[k] += (a[k] + b[k] + d[k]) * triangle_area / 3;
+					normal[k] += n[k];
+				}
+				area += triangle_area;
+			}
+			const float normal_length{std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2])};
+			if (area == 0.0F || normal_length == 0.0F) {
+				cluster_keys[c] = 0.0F;
+				continue;
+			}
+			float key{0.0F};
+			for (unsigned int k{0}; k < 3; ++k) {
+				key += (centroid[k] / area - mesh_centroid[k]) * normal[k] / normal_length;
+			}
+			cluster_keys[c] = key;
+		}
+
+		std::vector<std::size_t> order(cluster_count);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&cluster_keys](const std::size_t a, const std::size_t b) {
+			return cluster_keys[a] > cluster_keys[b];
+		});
+
+		std::vector<unsigned int> sorted;
+		sorted.reserve(indices.size());
+		for (const std::size_t c : order) {
+			sorted.insert(sorted.end(), indices.begin() + cluster_starts[c] * 3, indices.begin() + cluster_starts[c + 1] * 3);
+		}
+		indices.swap(sorted);
+	}
+
+	void optimise_vertex_fetch(
+			std::vector<unsigned int> &indices,
+			std::vector<float> &vertices,
+			std::vector<float> &normals
+			)
+	{
+		constexpr unsigned int unmapped{std::numeric_limits<unsigned int>::max()};
+		std::vector<unsigned int> remap(vertices.size() / 3, unmapped);
+		unsigned int next{0};
+		for (unsigned int &i : indices) {
+			if (remap[i] == unmapped) {
+				remap[i] = next++;
+			}
+			i = remap[i];
+		}
+
+		std::vector<float> fetch_vertices(next * 3), fetch_normals(next * 3);
+		for (std::size_t v{0}; v < remap.size(); ++v) {
+			if (remap[v] == unmapped) {
+				continue;
+			}
+			std::copy_n(vertices.begin() + v * 3, 3, fetch_vertices.begin() + remap[v] * 3);
+			std::copy_n(normals.begin() + v * 3, 3, fetch_normals.begin() + remap[v] * 3);
+		}
+		vertices.swap(fetch_vertices);
+		normals.swap(fetch_normals);
+	}
+
+	void optimise_mesh(
+			std::vector<unsigned int> &indices,
+			std::vector<float> &vertices,
+			std::vector<float> &normals
+			)
+	{
+		optimise_vertex_cache(indices, vertices.size() / 3);
+		optimise_overdraw(indices, vertices);
+		optimise_vertex_fetch(indices, vertices, normals);
+	}
+
+	unsigned int pack_normal(const float x, const float y, const float z)
+	{
+		const auto pack{[](const float c) -> unsigned int {
+			const int q{static_cast<int>(std::round(std::clamp(c, -1.0F, 1.0F) * 511.0F))};
+			return static_cast<unsigned int>(q) & 0x3FF;
+		}};
+		return pack(x) | (pack(y) << 10) | (pack(z) << 20);
+	}
+}
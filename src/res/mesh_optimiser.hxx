@@ -0,0 +1,30 @@
+#ifndef RES_MESH_OPTIMISER
+#define RES_MESH_OPTIMISER
+
+#include <vector>
+
+namespace res
+{
+	// Reorders triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm).
+	void optimise_vertex_cache(std::vector<unsigned int> &indices, const unsigned int vertex_count);
+	// Splits cache-optimised triangles into clusters at cache restarts and sorts the clusters
+	// so that outward-facing regions are drawn first, without breaking cache locality.
+	void optimise_overdraw(std::vector<unsigned int> &indices, const std::vector<float> &vertices);
+	// Renumbers vertices in first-use order so that vertex fetches walk memory linearly.
+	// Vertices no triangle references are dropped.
+	void optimise_vertex_fetch(
+			std::vector<unsigned int> &indices,
+			std::vector<float> &vertices,
+			std::vector<float> &normals
+			);
+	void optimise_mesh(
+			std::vector<unsigned int> &indices,
+			std::vector<float> &vertices,
+			std::vector<float> &normals
+			);
+
+	// Packs a unit normal into GL_INT_2_10_10_10_REV layout.
+	unsigned int pack_normal(const float x, const float y, const float z);
+}
+
+#endif
@@ -1,64 +1,143 @@
 #include "model_resource.hxx"
 
 #include <iostream>
+#include <limits>
+#include <algorithm>
+#include <utility>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <glbinding/gl/gl.h>
-
-#ifndef NDEBUG
-#include <cassert>
-#include <vector>
-#include <numbers>
-#include <matrix.hxx>
-#include <polar.hxx>
-#include <util.hxx>
-#endif
+#include <mesh_optimiser.hxx>
+#include <deferred_deletion.hxx>
 
 namespace res
 {
+	namespace
+	{
+		unsigned int create_buffer(const std::size_t size, const void *data, const gl::BufferStorageMask flags)
+		{
+			unsigned int buffer;
+			gl::glCreateBuffers(1, &buffer);
+			// zero sized storage is an error, empty meshes still get a buffer
+			gl::glNamedBufferStorage(buffer, std::max<std::size_t>(size, 1), data, flags);
+			return buffer;
+		}
+	}
+
 	ModelResource::Mesh::Mesh(
 			const std::vector<float> vertices,
 			const std::vector<float> normals,
 			const std::vector<unsigned int> indices
 			)
-		:vertices{vertices}, normals{normals}, indices{indices}
+		:vertices{vertices}, normals{normals}, indices{indices},
+		vertex_count{static_cast<unsigned int>(vertices.size() / 3)},
+		index_count{static_cast<unsigned int>(indices.size())},
+		index_type{index_type_for(vertex_count)}
 	{
-		gl::glGenVertexArrays(1, &vao);	
-		gl::glGenBuffers(1, &vbo);
-		gl::glGenBuffers(1, &ebo);
-		gl::glGenBuffers(1, &nbo);
-
-		gl::glBindVertexArray(vao);
+		for (std::size_t i{0}; i + 2 < vertices.size(); i += 3) {
+			bounds.expand(vertices[i], vertices[i + 1], vertices[i + 2]);
+		}
 
-		gl::glBindBuffer(gl::GL_ARRAY_BUFFER, vbo);
-		gl::glBufferData(gl::GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), gl::GL_STATIC_DRAW);
-		gl::glEnableVertexAttribArray(0);
-		gl::glVertexAttribPointer(0, 3, gl::GL_FLOAT, false, 0, reinterpret_cast<void*>(0));
+		std::vector<unsigned int> packed_normals;
+		packed_normals.reserve(normals.size() / 3);
+		for (std::size_t i{0}; i + 2 < normals.size(); i += 3) {
+			packed_normals.push_back(pack_normal(normals[i], normals[i + 1], normals[i + 2]));
+		}
 
-		gl::glBindBuffer(gl::GL_ARRAY_BUFFER, nbo);
-		gl::glBufferData(gl::GL_ARRAY_BUFFER, normals.size() * sizeof(float), normals.data(), gl::GL_STATIC_DRAW);
-		gl::glEnableVertexAttribArray(1);
-		gl::glVertexAttribPointer(1, 3, gl::GL_FLOAT, false, 0, reinterpret_cast<void*>(0));
+		vbo = create_buffer(vertices.size() * sizeof(float), vertices.data(), gl::GL_NONE_BIT);
+		nbo = create_buffer(packed_normals.size() * sizeof(unsigned int), packed_normals.data(), gl::GL_NONE_BIT);
+		if (index_type == gl::GL_UNSIGNED_SHORT) {
+			const std::vector<unsigned short> short_indices(indices.begin(), indices.end());
+			ebo = create_buffer(short_indices.size() * sizeof(unsigned short), short_indices.data(), gl::GL_NONE_BIT);
+		} else {
+			ebo = create_buffer(indices.size() * sizeof(unsigned int), indices.data(), gl::GL_NONE_BIT);
+		}
+		create_vertex_array();
+	}
 
-		gl::glBindBuffer(gl::GL_ELEMENT_ARRAY_BUFFER, ebo);
-		gl::glBufferData(gl::GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), gl::GL_STATIC_DRAW);
+	ModelResource::Mesh::Mesh(
+			const unsigned int vertex_count,
+			const unsigned int index_count,
+			const std::function<Aabb(const MappedData &data)> &fill
+			)
+		:vertex_count{vertex_count}, index_count{index_count}, index_type{index_type_for(vertex_count)}
+	{
+		const std::size_t vertex_size{vertex_count * 3 * sizeof(float)};
+		const std::size_t normal_size{vertex_count * sizeof(unsigned int)};
+		const std::size_t index_size{index_count * get_index_size()};
+		vbo = create_buffer(vertex_size, nullptr, gl::GL_MAP_WRITE_BIT);
+		nbo = create_buffer(normal_size, nullptr, gl::GL_MAP_WRITE_BIT);
+		ebo = create_buffer(index_size, nullptr, gl::GL_MAP_WRITE_BIT);
 
-		gl::glBindBuffer(gl::GL_ARRAY_BUFFER, 0);
-		gl::glBindVertexArray(0);
-		gl::glBindBuffer(gl::GL_ELEMENT_ARRAY_BUFFER, 0);
+		const auto map{[](const unsigned int buffer, const std::size_t size) {
+			return gl::glMapNamedBufferRange(
+					buffer,
+					0,
+					std::max<std::size_t>(size, 1),
+					gl::GL_MAP_WRITE_BIT | gl::GL_MAP_INVALIDATE_BUFFER_BIT
+					);
+		}};
+		const MappedData data{
+			static_cast<float*>(map(vbo, vertex_size)),
+			static_cast<unsigned int*>(map(nbo, normal_size)),
+			map(ebo, index_size),
+			index_type
+		};
+		bounds = fill(data);
+		gl::glUnmapNamedBuffer(vbo);
+		gl::glUnmapNamedBuffer(nbo);
+		gl::glUnmapNamedBuffer(ebo);
+		create_vertex_array();
 	}
 
 	ModelResource::Mesh::Mesh(const Mesh &other)
-		:Mesh(other.vertices, other.normals, other.indices)
+		:vertices{other.vertices}, normals{other.normals}, indices{other.indices},
+		vertex_count{other.vertex_count}, index_count{other.index_count},
+		index_type{other.index_type}, bounds{other.bounds}
 	{
+		// copied on the GPU, so meshes without a CPU copy can be copied too
+		const auto copy{[](const unsigned int source, const std::size_t size) {
+			const unsigned int buffer{create_buffer(size, nullptr, gl::GL_NONE_BIT)};
+			if (size > 0) {
+				gl::glCopyNamedBufferSubData(source, buffer, 0, 0, size);
+			}
+			return buffer;
+		}};
+		vbo = copy(other.vbo, vertex_count * 3 * sizeof(float));
+		nbo = copy(other.nbo, vertex_count * sizeof(unsigned int));
+		ebo = copy(other.ebo, index_count * get_index_size());
+		create_vertex_array();
+	}
+
+	ModelResource::Mesh::Mesh(Mesh &&other) noexcept
+		:vertices{std::move(other.vertices)}, normals{std::move(other.normals)}, indices{std::move(other.indices)},
+		vertex_count{other.vertex_count}, index_count{other.index_count},
+		vao{other.vao}, vbo{other.vbo}, ebo{other.ebo}, nbo{other.nbo},
+		index_type{other.index_type}, bounds{other.bounds}
+	{
+		other.vertex_count = 0;
+		other.index_count = 0;
+		other.vao = 0;
+		other.vbo = 0;
+		other.ebo = 0;
+		other.nbo = 0;
 	}
 
 	ModelResource::Mesh::~Mesh()
 	{
-		gl::glDeleteBuffers(1, &vbo);
-		gl::glDeleteBuffers(1, &ebo);
-		gl::glDeleteBuffers(1, &nbo);
-		gl::glDeleteVertexArrays(1, &vao);
+		// a snapshot waiting to be rendered may still draw this mesh
+		defer_buffer_deletion(vbo);
+		defer_buffer_deletion(ebo);
+		defer_buffer_deletion(nbo);
+		defer_vertex_array_deletion(vao);
+	}
+
+	gl::GLenum ModelResource::Mesh::index_type_for(const unsigned int vertex_count)
+	{
+		if (vertex_count <= std::numeric_limits<unsigned short>::max()) {
+			return gl::GL_UNSIGNED_SHORT;
+		}
+		return gl::GL_UNSIGNED_INT;
 	}
 
 	unsigned int ModelResource::Mesh::get_vao() const
@@ -68,20 +147,97 @@ namespace res
 
 	unsigned int ModelResource::Mesh::get_index_count() const
 	{
-		return indices.size();
+		return index_count;
+	}
+
+	gl::GLenum ModelResource::Mesh::get_index_type() const
+	{
+		return index_type;
+	}
+
+	std::size_t ModelResource::Mesh::get_cpu_size() const
+	{
+		return sizeof(Mesh)
+			+ vertices.capacity() * sizeof(float)
+			+ normals.capacity() * sizeof(float)
+			+ indices.capacity() * sizeof(unsigned int);
+	}
+
+	std::size_t ModelResource::Mesh::get_gpu_size() const
+	{
+		return vertex_count * 3 * sizeof(float)
+			+ vertex_count * sizeof(unsigned int)
+			+ index_count * get_index_size();
+	}
+
+	const Aabb &ModelResource::Mesh::get_bounds() const
+	{
+		return bounds;
+	}
+
+	std::size_t ModelResource::Mesh::get_index_size() const
+	{
+		return index_type == gl::GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+	}
+
+	void ModelResource::Mesh::create_vertex_array()
+	{
+		gl::glGenVertexArrays(1, &vao);
+		gl::glBindVertexArray(vao);
+
+		gl::glBindBuffer(gl::GL_ARRAY_BUFFER, vbo);
+		gl::glEnableVertexAttribArray(0);
+		gl::glVertexAttribPointer(0, 3, gl::GL_FLOAT, false, 0, reinterpret_cast<void*>(0));
+
+		gl::glBindBuffer(gl::GL_ARRAY_BUFFER, nbo);
+		gl::glEnableVertexAttribArray(1);
+		gl::glVertexAttribPointer(1, 4, gl::GL_INT_2_10_10_10_REV, true, 0, reinterpret_cast<void*>(0));
+
+		gl::glBindBuffer(gl::GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+		gl::glBindBuffer(gl::GL_ARRAY_BUFFER, 0);
+		gl::glBindVertexArray(0);
+		gl::glBindBuffer(gl::GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 
 	void ModelResource::load(const std::string path)
 	{
 		static Assimp::Importer importer;
-		const aiScene *scene{importer.ReadFile(path, aiProcess_Triangulate)};
-		if (scene == nullptr) std::cerr << importer.GetErrorString() << std::endl;
+		const aiScene *scene{importer.ReadFile(path, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices)};
+		if (scene == nullptr) {
+			std::cerr << importer.GetErrorString() << std::endl;
+			return;
+		}
 
 		load_ainode(scene->mRootNode, scene);
+		for (const Mesh &mesh : meshes) {
+			bounds.expand(mesh.get_bounds());
+		}
 	}
 
 	void ModelResource::unload()
 	{
+		meshes.clear();
+		meshes.shrink_to_fit();
+		bounds = Aabb{};
+	}
+
+	std::size_t ModelResource::get_cpu_size() const
+	{
+		std::size_t size{0};
+		for (const Mesh &mesh : meshes) {
+			size += mesh.get_cpu_size();
+		}
+		return size;
+	}
+
+	std::size_t ModelResource::get_gpu_size() const
+	{
+		std::size_t size{0};
+		for (const Mesh &mesh : meshes) {
+			size += mesh.get_gpu_size();
+		}
+		return size;
 	}
 
 	const std::vector<ModelResource::Mesh> &ModelResource::get_meshes() const
@@ -89,6 +245,11 @@ namespace res
 		return meshes;
 	}
 
+	const Aabb &ModelResource::get_bounds() const
+	{
+		return bounds;
+	}
+
 	void ModelResource::load_ainode(aiNode *node, const aiScene *scene)
 	{
 		for (unsigned int i{0}; i < node->mNumMeshes; ++i) {
@@ -110,128 +271,11 @@ namespace res
 					indices.push_back(face.mIndices[j]);
 				}
 			}
+			optimise_mesh(indices, vertices, normals);
 			meshes.emplace_back(vertices, normals, indices);
 		}
 		for (unsigned int i{0}; i < node->mNumChildren; ++i) {
 			load_ainode(node->mChildren[i], scene);
 		}
 	}
-
-#ifndef NDEBUG
-	ModelResource::Mesh spherical_mesh(
-		const float radius,
-		const unsigned int longitudes,
-		const unsigned int latitudes
-		)
-	{
-		assert(radius > 0);
-		assert(longitudes > 0);
-		assert(latitudes > 0);
-
-		const float lon_step{(2 * std::numbers::pi_v<float>) / longitudes};
-		const float half_lon_step{lon_step / 2};
-		const float lat_step{std::numbers::pi_v<float> / (latitudes + 1)};
-		const float depression_to_point_up{-std::numbers::pi_v<float> / 2};
-
-		std::vector<float> points;
-		points.reserve((longitudes * latitudes + 2) * 3);
-		// top point
-		points.insert(points.begin(), {0, radius, 0});
-		// formation points
-		for (int lat{0}; lat < latitudes; ++lat) {
-			const float current_lat{lat_step * (lat + 1)};
-			for (int lon{0}; lon < longitudes; ++lon) {
-				const midnight::Polar t{radius, lon * lon_step, depression_to_point_up + current_lat};
-				midnight::Vector3 c{midnight::cartesian3(t)};
-				if (std::fabs(c.entry(0, 0)) < 0.00001F) {
-					c.entry(0, 0) = 0.0F;
-				}
-				if (std::fabs(c.entry(1, 0)) < 0.00001F) {
-					c.entry(1, 0) = 0.0F;
-				}
-				if (std::fabs(c.entry(2, 0)) < 0.00001F) {
-					c.entry(2, 0) = 0.0F;
-				}
-				points.push_back(c.entry(0, 0));
-				points.push_back(c.entry(1, 0));
-				points.push_back(c.entry(2, 0));
-			}
-		}
-		// bottom point
-		points.insert(points.end(), {0, -radius, 0});
-
-		std::vector<unsigned int> indices;
-		indices.reserve(longitudes * latitudes * 6);
-		// connect top to first latitude
-		for (int lon{0}; lon < longitudes; ++lon) {
-			indices.push_back(0);
-			indices.push_back(1 + lon);
-			indices.push_back(1 + (lon != longitudes - 1 ? lon + 1 : 0));
-		}
-		// connect latitudes to each other
-		if (latitudes > 1) {
-			for (int lat{0}; lat < latitudes - 1; ++lat) {
-				const unsigned int lat_offset{lat * longitudes};
-				const unsigned int next_lat_offset{(1 + lat) * longitudes};
-				for (int lon{0}; lon < longitudes; ++lon) {
-					const int lon_wrap{lon != longitudes - 1 ? lon + 1 : 0};
-					// first triangle
-					indices.push_back(1 + lat_offset + lon);
-					indices.push_back(1 + next_lat_offset + lon);
-					indices.push_back(1 + next_lat_offset + lon_wrap);
-					// second triangle to complete the rectangle
-					indices.push_back(1 + lat_offset + lon);
-					indices.push_back(1 + next_lat_offset + lon_wrap);
-					indices.push_back(1 + lat_offset + lon_wrap);
-				}
-			}
-		}
-		// connect bottom to last latitude
-		// the bottom point is defined as longitudes * latitudes + 1
-		for (int lon{0}; lon < longitudes; ++lon) {
-			indices.push_back(1 + (latitudes - 1) * longitudes + lon);
-			indices.push_back(1 + longitudes * latitudes);
-			indices.push_back(1 + (latitudes - 1) * longitudes + (lon != longitudes - 1 ? lon + 1 : 0));
-		}
-		
-		std::vector<float> normals;
-		normals.reserve((longitudes * latitudes + 2) * 3);
-		std::vector<std::vector<unsigned int>> point_triangles(longitudes * latitudes + 2);
-		point_triangles.front().reserve(longitudes * 3);
-		point_triangles.back().reserve(longitudes * 3);
-		for (auto t{point_triangles.begin() + 1}; t != point_triangles.end() - 1; ++t) {
-			t->reserve(15);
-		}
-		// index triangles
-		for (auto t{indices.begin()}; t != indices.end(); t += 3) {
-			const unsigned int a{*t}, b{*(t + 1)}, c{*(t + 2)};
-			point_triangles.at(a).push_back(a);
-			point_triangles.at(a).push_back(b);
-			point_triangles.at(a).push_back(c);
-			point_triangles.at(b).push_back(a);
-			point_triangles.at(b).push_back(b);
-			point_triangles.at(b).push_back(c);
-			point_triangles.at(c).push_back(a);
-			point_triangles.at(c).push_back(b);
-			point_triangles.at(c).push_back(c);
-		}
-		// compute normals
-		for (int p{0}; p < longitudes * latitudes + 2; ++p) {
-			midnight::Vector3 n;
-			for (auto t{point_triangles.at(p).begin()}; t != point_triangles.at(p).end(); t += 3) {
-				const unsigned int a{*t}, b{*(t + 1)}, c{*(t + 2)};
-				const midnight::Vector3 v1{points.at(a * 3), points.at(a * 3 + 1), points.at(a * 3 + 2)};
-				const midnight::Vector3 v2{points.at(b * 3), points.at(b * 3 + 1), points.at(b * 3 + 2)};
-				const midnight::Vector3 v3{points.at(c * 3), points.at(c * 3 + 1), points.at(c * 3 + 2)};
-				n += midnight::cross(v1 - v3, v2 - v3);
-			}
-			n = midnight::normalise(n);
-			normals.push_back(n.entry(0, 0));
-			normals.push_back(n.entry(1, 0));
-			normals.push_back(n.entry(2, 0));
-		}
-
-		return ModelResource::Mesh(points, normals, indices);
-	}
-#endif
 }
@@ -2,8 +2,11 @@
 #define RES_MODEL_RESOURCE
 
 #include <vector>
+#include <functional>
 #include <assimp/scene.h>
+#include <glbinding/gl/types.h>
 #include <resource.hxx>
+#include <bvh.hxx>
 
 namespace res
 {
@@ -13,46 +16,74 @@ namespace res
 		class Mesh final
 		{
 		public:
+			// Buffers of a mesh mapped for writing. Normals are packed with pack_normal, and
+			// indices are unsigned short or unsigned int as index_type says.
+			struct MappedData
+			{
+				float *positions;
+				unsigned int *normals;
+				void *indices;
+				gl::GLenum index_type;
+			};
+
 			Mesh(
 					const std::vector<float> vertices,
 					const std::vector<float> normals,
 					const std::vector<unsigned int> indices
 					);
+			// Maps the buffers and hands them to fill, which has to write every vertex and index
+			// and return the bounds. No copy of the data is kept on the CPU.
+			Mesh(
+					const unsigned int vertex_count,
+					const unsigned int index_count,
+					const std::function<Aabb(const MappedData &data)> &fill
+					);
 			Mesh(const Mesh &other);
+			Mesh(Mesh &&other) noexcept;
 			~Mesh();
 
 			Mesh &operator=(const Mesh &other) = delete;
 
+			static gl::GLenum index_type_for(const unsigned int vertex_count);
+
 			unsigned int get_vao() const;
 			unsigned int get_index_count() const;
+			gl::GLenum get_index_type() const;
+			std::size_t get_cpu_size() const;
+			std::size_t get_gpu_size() const;
+			const Aabb &get_bounds() const;
 
 
 		private:
+			// empty for meshes that were written straight into their buffers
 			std::vector<float> vertices;
 			std::vector<float> normals;
 			std::vector<unsigned int> indices;
 
-			unsigned int vao, vbo, ebo, nbo;
+			unsigned int vertex_count{0};
+			unsigned int index_count{0};
+			unsigned int vao{0}, vbo{0}, ebo{0}, nbo{0};
+			gl::GLenum index_type;
+			Aabb bounds;
+
+			std::size_t get_index_size() const;
+			void create_vertex_array();
 		};
 
 		virtual void load(const std::string path) override;
 		virtual void unload() override;
+		virtual std::size_t get_cpu_size() const override;
+		virtual std::size_t get_gpu_size() const override;
 
 		const std::vector<Mesh> &get_meshes() const;
+		const Aabb &get_bounds() const;
 
 	private:
 		std::vector<Mesh> meshes;
+		Aabb bounds;
 
 		void load_ainode(aiNode *node, const aiScene *scene);
 	};
-
-#ifndef NDEBUG
-	ModelResource::Mesh spherical_mesh(
-		const float radius,
-		const unsigned int longitudes,
-		const unsigned int latitudes
-		);
-#endif
 }
 
 #endif
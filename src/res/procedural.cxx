@@ -0,0 +1,437 @@
+#include "procedural.hxx"
+
+#include <cmath>
+#include <cassert>
+#include <array>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <numbers>
+#include <algorithm>
+#include <glbinding/gl/gl.h>
+#include <mesh_optimiser.hxx>
+
+namespace res
+{
+	namespace
+	{
+		// below this many vertices or triangles per chunk a thread costs more than it saves
+		constexpr std::size_t minimum_chunk{16384};
+
+		using Triangle = std::array<unsigned int, 3>;
+
+		// Splits [0, count) into a chunk per hardware thread, the calling thread takes the first.
+		void parallel_for(const std::size_t count, const std::function<void(const std::size_t begin, const std::size_t end)> &job)
+		{
+			const std::size_t hardware{std::max(std::thread::hardware_concurrency(), 1U)};
+			const std::size_t chunks{std::clamp<std::size_t>(count / minimum_chunk, 1, hardware)};
+			const std::size_t chunk_size{(count + chunks - 1) / chunks};
+			std::vector<std::jthread> workers;
+			workers.reserve(chunks - 1);
+			for (std::size_t c{1}; c < chunks; ++c) {
+				workers.emplace_back(job, std::min(count, c * chunk_size), std::min(count, (c + 1) * chunk_size));
+			}
+			job(0, std::min(count, chunk_size));
+		}
+
+		void assign(float out[3], const float x, const float y, const float z)
+		{
+			out[0] = x;
+			out[1] = y;
+			out[2] = z;
+		}
+
+		// vertex(i, position, normal) is called for every vertex and triangle(i) for every triangle,
+		// both from several threads at once.
+		template<class V, class T>
+		ModelResource::Mesh generate(
+				const unsigned int vertex_count,
+				const unsigned int triangle_count,
+				const V &vertex,
+				const T &triangle
+				)
+		{
+			return ModelResource::Mesh(vertex_count, triangle_count * 3, [&](const ModelResource::Mesh::MappedData &data) {
+				Aabb bounds;
+				std::mutex bounds_mutex;
+				parallel_for(vertex_count, [&](const std::size_t begin, const std::size_t end) {
+					// bounds are taken before the write, mapped memory is slow to read back
+					Aabb chunk_bounds;
+					for (std::size_t i{begin}; i < end; ++i) {
+						float position[3], normal[3];
+						vertex(static_cast<unsigned int>(i), position, normal);
+						chunk_bounds.expand(position[0], position[1], position[2]);
+						std::copy_n(position, 3, data.positions + i * 3);
+						data.normals[i] = pack_normal(normal[0], normal[1], normal[2]);
+					}
+					const std::lock_guard lock{bounds_mutex};
+					bounds.expand(chunk_bounds);
+				});
+
+				const auto write{[&](auto *indices, const std::size_t begin, const std::size_t end) {
+					using Index = std::remove_pointer_t<decltype(indices)>;
+					for (std::size_t t{begin}; t < end; ++t) {
+						const Triangle corners{triangle(static_cast<unsigned int>(t))};
+						for (unsigned int k{0}; k < 3; ++k) {
+							indices[t * 3 + k] = static_cast<Index>(corners[k]);
+						}
+					}
+				}};
+				parallel_for(triangle_count, [&](const std::size_t begin, const std::size_t end) {
+					if (data.index_type == gl::GL_UNSIGNED_SHORT) {
+						write(static_cast<unsigned short*>(data.indices), begin, end);
+					} else {
+						write(static_cast<unsigned int*>(data.indices), begin, end);
+					}
+				});
+				return bounds;
+			});
+		}
+
+		// Points of a grid columns wide, numbered row by row with those that have x in
+		// [hole_begin[0], hole_end[0]) and z in [hole_begin[1], hole_end[1]) skipped, so the rows
+		// through the hole are missing its width.
+		struct HoledGrid
+		{
+			unsigned int columns;
+			std::array<unsigned int, 2> hole_begin;
+			std::array<unsigned int, 2> hole_end;
+
+			unsigned int count(const unsigned int rows) const
+			{
+				return columns * rows - (hole_end[0] - hole_begin[0]) * (hole_end[1] - hole_begin[1]);
+			}
+
+			std::array<unsigned int, 2> point(unsigned int n) const
+			{
+				const unsigned int hole{hole_end[0] - hole_begin[0]};
+				const unsigned int before_hole{hole_begin[1] * columns};
+				const unsigned int through_hole{(hole_end[1] - hole_begin[1]) * (columns - hole)};
+				if (n < before_hole) {
+					return {n % columns, n / columns};
+				}
+				n -= before_hole;
+				if (n < through_hole) {
+					const unsigned int x{n % (columns - hole)};
+					return {x < hole_begin[0] ? x : x + hole, hole_begin[1] + n / (columns - hole)};
+				}
+				n -= through_hole;
+				return {n % columns, hole_end[1] + n / columns};
+			}
+
+			unsigned int index(const unsigned int x, const unsigned int z) const
+			{
+				const unsigned int hole{hole_end[0] - hole_begin[0]};
+				if (z < hole_begin[1]) {
+					return z * columns + x;
+				}
+				const unsigned int before_hole{hole_begin[1] * columns};
+				if (z < hole_end[1]) {
+					assert(x < hole_begin[0] || x >= hole_end[0]);
+					return before_hole + (z - hole_begin[1]) * (columns - hole) + (x < hole_begin[0] ? x : x - hole);
+				}
+				return before_hole + (hole_end[1] - hole_begin[1]) * (columns - hole) + (z - hole_end[1]) * columns + x;
+			}
+		};
+
+		// Triangle t of a grid, for the cell at x and z.
+		Triangle grid_triangle(const HoledGrid &vertices, const unsigned int x, const unsigned int z, const unsigned int t)
+		{
+			if (t % 2 == 0) {
+				return {vertices.index(x, z), vertices.index(x, z + 1), vertices.index(x + 1, z)};
+			}
+			return {vertices.index(x + 1, z), vertices.index(x, z + 1), vertices.index(x + 1, z + 1)};
+		}
+	}
+
+	ModelResource::Mesh spherical_mesh(
+			const float radius,
+			const unsigned int longitudes,
+			const unsigned int latitudes
+			)
+	{
+		assert(radius > 0);
+		assert(longitudes > 0);
+		assert(latitudes > 0);
+
+		const float lon_step{(2 * std::numbers::pi_v<float>) / longitudes};
+		const float lat_step{std::numbers::pi_v<float> / (latitudes + 1)};
+		const float depression_to_point_up{-std::numbers::pi_v<float> / 2};
+		// the top point comes first, then the latitudes from the top down, then the bottom point
+		const unsigned int bottom{longitudes * latitudes + 1};
+		const unsigned int band_triangles{2 * longitudes * (latitudes - 1)};
+		const auto ring{[=](const unsigned int lat, const unsigned int lon) {
+			return 1 + lat * longitudes + lon % longitudes;
+		}};
+
+		return generate(
+				bottom + 1,
+				2 * longitudes * latitudes,
+				[&](const unsigned int v, float position[3], float normal[3]) {
+					if (v == 0 || v == bottom) {
+						assign(normal, 0.0F, v == 0 ? 1.0F : -1.0F, 0.0F);
+					} else {
+						const float depression{depression_to_point_up + lat_step * ((v - 1) / longitudes + 1)};
+						const float heading{lon_step * ((v - 1) % longitudes)};
+						assign(
+								normal,
+								std::cos(depression) * std::sin(heading),
+								-std::sin(depression),
+								std::cos(depression) * std::cos(heading)
+								);
+					}
+					assign(position, radius * normal[0], radius * normal[1], radius * normal[2]);
+				},
+				[&](const unsigned int t) -> Triangle {
+					if (t < longitudes) {
+						return {0, ring(0, t), ring(0, t + 1)};
+					}
+					if (t >= longitudes + band_triangles) {
+						const unsigned int lon{t - longitudes - band_triangles};
+						return {ring(latitudes - 1, lon), bottom, ring(latitudes - 1, lon + 1)};
+					}
+					const unsigned int quad{(t - longitudes) / 2};
+					const unsigned int lat{quad / longitudes}, lon{quad % longitudes};
+					if ((t - longitudes) % 2 == 0) {
+						return {ring(lat, lon), ring(lat + 1, lon), ring(lat + 1, lon + 1)};
+					}
+					return {ring(lat, lon), ring(lat + 1, lon + 1), ring(lat, lon + 1)};
+				}
+				);
+	}
+
+	ModelResource::Mesh icosphere_mesh(const float radius, const unsigned int frequency)
+	{
+		assert(radius > 0);
+		assert(frequency > 0);
+
+		constexpr float phi{std::numbers::phi_v<float>};
+		static constexpr float corners[12][3]{
+			{-1, phi, 0}, {1, phi, 0}, {-1, -phi, 0}, {1, -phi, 0},
+			{0, -1, phi}, {0, 1, phi}, {0, -1, -phi}, {0, 1, -phi},
+			{phi, 0, -1}, {phi, 0, 1}, {-phi, 0, -1}, {-phi, 0, 1}
+		};
+		static constexpr unsigned int faces[20][3]{
+			{0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+			{1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+			{3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+			{4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+		};
+
+		// Every face is a triangular grid with frequency + 1 - i vertices in row i, running from
+		// its first corner towards its second, and 2 * (frequency - i) - 1 triangles between
+		// rows i and i + 1. Faces don't share vertices so each can be written on its own.
+		const unsigned int f{frequency};
+		const unsigned int face_vertices{(f + 1) * (f + 2) / 2};
+		const unsigned int face_triangles{f * f};
+		const auto vertex_row{[f](const unsigned int i) {
+			return (i * (2 * f + 3) - i * i) / 2;
+		}};
+		const auto triangle_row{[f](const unsigned int i) {
+			return 2 * f * i - i * i;
+		}};
+		// inverts a row offset, the estimate solved from the quadratic can be a row out either way
+		const auto find_row{[f](const unsigned int n, const auto &row, const float estimate) {
+			unsigned int i{std::min(static_cast<unsigned int>(std::max(estimate, 0.0F)), f)};
+			while (i > 0 && row(i) > n) {
+				--i;
+			}
+			while (i < f && row(i + 1) <= n) {
+				++i;
+			}
+			return i;
+		}};
+		const auto index{[&](const unsigned int face, const unsigned int i, const unsigned int j) {
+			return face * face_vertices + vertex_row(i) + j;
+		}};
+
+		return generate(
+				20 * face_vertices,
+				20 * face_triangles,
+				[&](const unsigned int v, float position[3], float normal[3]) {
+					const unsigned int face{v / face_vertices}, n{v % face_vertices};
+					const float b{static_cast<float>(2 * f + 3)};
+					const unsigned int i{find_row(n, vertex_row, (b - std::sqrt(b * b - 8.0F * n)) / 2)};
+					const unsigned int j{n - vertex_row(i)};
+					// summed in corner order so that vertices on an edge two faces share come out bit identical
+					std::array<std::pair<unsigned int, unsigned int>, 3> weights{{
+						{faces[face][0], f - i - j},
+						{faces[face][1], i},
+						{faces[face][2], j}
+					}};
+					std::sort(weights.begin(), weights.end());
+					float point[3]{0.0F, 0.0F, 0.0F};
+					for (const auto &[corner, weight] : weights) {
+						for (unsigned int k{0}; k < 3; ++k) {
+							point[k] += corners[corner][k] * weight;
+						}
+					}
+					const float length{std::hypot(point[0], point[1], point[2])};
+					assign(normal, point[0] / length, point[1] / length, point[2] / length);
+					assign(position, radius * normal[0], radius * normal[1], radius * normal[2]);
+				},
+				[&](const unsigned int t) -> Triangle {
+					const unsigned int face{t / face_triangles}, n{t % face_triangles};
+					const float ff{static_cast<float>(f)};
+					const unsigned int i{find_row(n, triangle_row, ff - std::sqrt(ff * ff - n))};
+					const unsigned int m{n - triangle_row(i)}, j{m / 2};
+					if (m % 2 == 0) {
+						return {index(face, i, j), index(face, i + 1, j), index(face, i, j + 1)};
+					}
+					return {index(face, i + 1, j), index(face, i + 1, j + 1), index(face, i, j + 1)};
+				}
+				);
+	}
+
+	ModelResource::Mesh grid_mesh(
+			const unsigned int width,
+			const unsigned int depth,
+			const float cell_size,
+			const unsigned int hole_begin,
+			const unsigned int hole_end
+			)
+	{
+		assert(width > 0);
+		assert(depth > 0);
+		assert(cell_size > 0);
+		assert(hole_begin <= hole_end && hole_end <= std::min(width, depth));
+
+		// a vertex is only left out if every cell around it is, which keeps the hole's rim and
+		// drops the grid's border where the hole reaches it
+		const HoledGrid cells{width, {hole_begin, hole_begin}, {hole_end, hole_end}};
+		HoledGrid vertices{width + 1, {0, 0}, {0, 0}};
+		if (hole_begin < hole_end) {
+			const unsigned int sides[2]{width, depth};
+			for (unsigned int k{0}; k < 2; ++k) {
+				vertices.hole_begin[k] = hole_begin == 0 ? 0 : hole_begin + 1;
+				vertices.hole_end[k] = hole_end == sides[k] ? hole_end + 1 : hole_end;
+			}
+		}
+
+		return generate(
+				vertices.count(depth + 1),
+				2 * cells.count(depth),
+				[&](const unsigned int v, float position[3], float normal[3]) {
+					const auto [x, z]{vertices.point(v)};
+					assign(position, cell_size * x, 0.0F, cell_size * z);
+					assign(normal, 0.0F, 1.0F, 0.0F);
+				},
+				[&](const unsigned int t) {
+					const auto [x, z]{cells.point(t / 2)};
+					return grid_triangle(vertices, x, z, t);
+				}
+				);
+	}
+
+	ModelResource::Mesh terrain_mesh(
+			const unsigned int width,
+			const unsigned int depth,
+			const float cell_size,
+			const std::function<float(const float x, const float z)> &height
+			)
+	{
+		assert(width > 0);
+		assert(depth > 0);
+		assert(cell_size > 0);
+
+		const HoledGrid vertices{width + 1, {0, 0}, {0, 0}};
+		return generate(
+				(width + 1) * (depth + 1),
+				2 * width * depth,
+				[&](const unsigned int v, float position[3], float normal[3]) {
+					const float x{cell_size * (v % (width + 1))};
+					const float z{cell_size * (v / (width + 1))};
+					assign(position, x, height(x, z), z);
+					// central differences of the height field, which also reach past the edges
+					const float dx{height(x - cell_size, z) - height(x + cell_size, z)};
+					const float dz{height(x, z - cell_size) - height(x, z + cell_size)};
+					const float length{std::hypot(dx, 2 * cell_size, dz)};
+					assign(normal, dx / length, 2 * cell_size / length, dz / length);
+				},
+				[&](const unsigned int t) {
+					return grid_triangle(vertices, t / 2 % width, t / 2 / width, t);
+				}
+				);
+	}
+
+	ModelResource::Mesh box_mesh(const float width, const float height, const float depth)
+	{
+		assert(width > 0);
+		assert(height > 0);
+		assert(depth > 0);
+
+		const float half[3]{width / 2, height / 2, depth / 2};
+		return generate(
+				24,
+				12,
+				[&](const unsigned int v, float position[3], float normal[3]) {
+					// faces go +x, +y, +z, -x, -y, -z, each spanned by the two other axes in the order
+					// whose cross product is its normal, with corners counter-clockwise around it
+					const unsigned int face{v / 4}, corner{v % 4};
+					const unsigned int axis{face % 3};
+					const bool negative{face >= 3};
+					const unsigned int u{(axis + (negative ? 2 : 1)) % 3};
+					const unsigned int w{(axis + (negative ? 1 : 2)) % 3};
+					const float sign{negative ? -1.0F : 1.0F};
+					std::fill_n(normal, 3, 0.0F);
+					normal[axis] = sign;
+					position[axis] = sign * half[axis];
+					position[u] = (corner == 1 || corner == 2 ? 1.0F : -1.0F) * half[u];
+					position[w] = (corner >= 2 ? 1.0F : -1.0F) * half[w];
+				},
+				[](const unsigned int t) -> Triangle {
+					const unsigned int first{t / 2 * 4};
+					if (t % 2 == 0) {
+						return {first, first + 1, first + 2};
+					}
+					return {first, first + 2, first + 3};
+				}
+				);
+	}
+
+	ModelResource::Mesh cylinder_mesh(const float radius, const float height, const unsigned int segments)
+	{
+		assert(radius > 0);
+		assert(height > 0);
+		assert(segments > 2);
+
+		// rings of segments vertices: bottom and top of the side, then bottom and top of the caps,
+		// which don't share the side's normals, then the centres of the bottom and top caps
+		const unsigned int s{segments};
+		const float step{(2 * std::numbers::pi_v<float>) / segments};
+		return generate(
+				4 * s + 2,
+				4 * s,
+				[&](const unsigned int v, float position[3], float normal[3]) {
+					const bool top{v >= 4 * s ? v == 4 * s + 1 : v / s % 2 == 1};
+					const float y{top ? height / 2 : -height / 2};
+					if (v >= 4 * s) {
+						assign(position, 0.0F, y, 0.0F);
+						assign(normal, 0.0F, top ? 1.0F : -1.0F, 0.0F);
+						return;
+					}
+					const float x{std::sin(step * (v % s))}, z{std::cos(step * (v % s))};
+					assign(position, radius * x, y, radius * z);
+					if (v < 2 * s) {
+						assign(normal, x, 0.0F, z);
+					} else {
+						assign(normal, 0.0F, top ? 1.0F : -1.0F, 0.0F);
+					}
+				},
+				[&](const unsigned int t) -> Triangle {
+					const unsigned int i{t % s}, next{(t + 1) % s};
+					if (t < s) {
+						return {i, next, s + next};
+					}
+					if (t < 2 * s) {
+						return {i, s + next, s + i};
+					}
+					if (t < 3 * s) {
+						return {4 * s, 2 * s + next, 2 * s + i};
+					}
+					return {4 * s + 1, 3 * s + i, 3 * s + next};
+				}
+				);
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef RES_PROCEDURAL
+#define RES_PROCEDURAL
+
+#include <functional>
+#include <model_resource.hxx>
+
+namespace res
+{
+	// Procedural meshes are generated in parallel chunks straight into mapped buffers, with
+	// normals taken from the shape itself instead of averaged over adjacent triangles.
+
+	// UV sphere with a vertex at each pole and latitudes rings of longitudes vertices.
+	ModelResource::Mesh spherical_mesh(
+			const float radius,
+			const unsigned int longitudes,
+			const unsigned int latitudes
+			);
+	// Icosahedron with every face split into frequency^2 triangles and pushed onto the sphere.
+	ModelResource::Mesh icosphere_mesh(const float radius, const unsigned int frequency);
+	// Grid of width by depth cells on y = 0 spanning from the origin towards +x and +z.
+	// Cells with both coordinates in [hole_begin, hole_end) are left out, along with the vertices
+	// that only they use.
+	ModelResource::Mesh grid_mesh(
+			const unsigned int width,
+			const unsigned int depth,
+			const float cell_size,
+			const unsigned int hole_begin = 0,
+			const unsigned int hole_end = 0
+			);
+	// Grid laid out as grid_mesh and lifted by height(x, z). height is called from several
+	// threads at once and must be safe to do so.
+	ModelResource::Mesh terrain_mesh(
+			const unsigned int width,
+			const unsigned int depth,
+			const float cell_size,
+			const std::function<float(const float x, const float z)> &height
+			);
+	// Box centred on the origin with flat shaded faces.
+	ModelResource::Mesh box_mesh(const float width, const float height, const float depth);
+	// Capped cylinder centred on the origin along y.
+	ModelResource::Mesh cylinder_mesh(const float radius, const float height, const unsigned int segments);
+}
+
+#endif
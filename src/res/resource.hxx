@@ -2,8 +2,14 @@
 #define RES_RESOURCE
 
 #include <unordered_map>
+#include <list>
+#include <deque>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <functional>
+#include <limits>
+#include <cstddef>
 #include <type_traits>
 
 namespace res
@@ -11,25 +17,100 @@ namespace res
 	class Resource;
 	template<class T>
 	concept ResourceType = std::is_base_of<Resource, T>::value;
+	template<ResourceType T>
+	class ResourceController;
 
 	class Resource
 	{
 	public:
 		virtual void load(const std::string path) = 0;
 		virtual void unload() = 0;
+		virtual std::size_t get_cpu_size() const = 0;
+		virtual std::size_t get_gpu_size() const = 0;
 	};
 
+	// Interned form of a resource key, resolved once and then used to retrieve by direct indexing.
+	template<ResourceType T>
+	class ResourceHandle final
+	{
+	public:
+		ResourceHandle() = default;
+
+		bool operator==(const ResourceHandle &other) const = default;
+
+		bool is_valid() const;
+
+	private:
+		unsigned int slot{std::numeric_limits<unsigned int>::max()};
+
+		explicit ResourceHandle(const unsigned int slot);
+
+		friend class ResourceController<T>;
+	};
+
+	// Resources are evicted by unloading them in place, so weak_ptrs handed out by retrieve stay
+	// valid and the resource is reloaded the next time it is retrieved. Only resources that nobody
+	// has locked are evicted, least recently retrieved first, so a consumer has to keep a resource
+	// locked for as long as it uses it, and retrieve it again each time it does for the order to
+	// follow its use. Locked resources can keep usage over a budget, is_over_budget tells when.
 	template<ResourceType T> 
 	class ResourceController final
 	{
 	public:
 		~ResourceController();
 
-		void index(const std::string key, const std::string path);
-		const std::weak_ptr<T> retrieve(const std::string key) const;
+		ResourceHandle<T> index(const std::string_view key, const std::string_view path);
+		ResourceHandle<T> handle(const std::string_view key) const;
+		const std::weak_ptr<T> &retrieve(const ResourceHandle<T> handle);
+		const std::weak_ptr<T> &retrieve(const std::string_view key);
+
+		void set_cpu_budget(const std::size_t budget);
+		void set_gpu_budget(const std::size_t budget);
+		std::size_t get_cpu_usage() const;
+		std::size_t get_gpu_usage() const;
+		bool is_over_budget() const;
+		unsigned long get_hit_count() const;
+		unsigned long get_miss_count() const;
+		unsigned long get_eviction_count() const;
+		unsigned long get_reload_count() const;
+		float get_hit_rate() const;
 
 	private:
-		std::unordered_map<std::string, std::shared_ptr<T>> resources;
+		struct Entry
+		{
+			std::string path;
+			std::shared_ptr<T> resource;
+			std::weak_ptr<T> view;
+			bool resident{false};
+			std::size_t cpu_size{0};
+			std::size_t gpu_size{0};
+			typename std::list<Entry*>::iterator lru_position;
+		};
+
+		struct KeyHash
+		{
+			using is_transparent = void;
+
+			std::size_t operator()(const std::string_view key) const;
+		};
+
+		// deque so that entries never move and the lru list can point at them
+		std::deque<Entry> resources;
+		std::unordered_map<std::string, unsigned int, KeyHash, std::equal_to<>> slots;
+		// front is the least recently retrieved
+		std::list<Entry*> lru;
+		std::size_t cpu_budget{std::numeric_limits<std::size_t>::max()};
+		std::size_t gpu_budget{std::numeric_limits<std::size_t>::max()};
+		std::size_t cpu_usage{0};
+		std::size_t gpu_usage{0};
+		unsigned long hits{0};
+		unsigned long misses{0};
+		unsigned long evictions{0};
+		unsigned long reloads{0};
+
+		void make_resident(Entry &entry);
+		void evict(Entry &entry);
+		void enforce_budgets(const Entry *keep);
 	};
 }
 
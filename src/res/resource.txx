@@ -1,26 +1,188 @@
 #include "resource.hxx"
 
+#include <iostream>
+#include <stdexcept>
+#include <cassert>
+
 namespace res
 {
+	template<ResourceType T>
+	ResourceHandle<T>::ResourceHandle(const unsigned int slot)
+		:slot{slot}
+	{
+	}
+
+	template<ResourceType T>
+	bool ResourceHandle<T>::is_valid() const
+	{
+		return slot != std::numeric_limits<unsigned int>::max();
+	}
+
 	template<ResourceType T>
 	ResourceController<T>::~ResourceController()
 	{
 		for (auto r{resources.begin()}; r != resources.end(); ++r) {
-			r->second->unload();
+			if (r->resident) {
+				r->resource->unload();
+			}
+		}
+	}
+
+	template<ResourceType T>
+	ResourceHandle<T> ResourceController<T>::index(const std::string_view key, const std::string_view path)
+	{
+		if (const auto s{slots.find(key)}; s != slots.end()) {
+			std::cerr << "ResourceController, attempted to index a key that already exists.\n";
+			return ResourceHandle<T>(s->second);
+		}
+		const unsigned int slot{static_cast<unsigned int>(resources.size())};
+		slots.emplace(key, slot);
+		Entry &entry{resources.emplace_back()};
+		entry.path = path;
+		entry.resource = std::make_shared<T>();
+		entry.view = entry.resource;
+		entry.lru_position = lru.insert(lru.end(), &entry);
+		make_resident(entry);
+		enforce_budgets(&entry);
+		return ResourceHandle<T>(slot);
+	}
+
+	template<ResourceType T>
+	ResourceHandle<T> ResourceController<T>::handle(const std::string_view key) const
+	{
+		const auto s{slots.find(key)};
+		if (s == slots.end()) {
+			throw std::out_of_range("ResourceController, attempted to resolve a key that isn't indexed.");
 		}
+		return ResourceHandle<T>(s->second);
 	}
 
 	template<ResourceType T>
-	void ResourceController<T>::index(const std::string key, const std::string path)
+	const std::weak_ptr<T> &ResourceController<T>::retrieve(const std::string_view key)
 	{
-		resources.insert({key, std::make_shared<T>()});
-		resources[key]->load(path);
+		return retrieve(handle(key));
 	}
 
+	template<ResourceType T>
+	const std::weak_ptr<T> &ResourceController<T>::retrieve(const ResourceHandle<T> handle)
+	{
+		assert(handle.slot < resources.size());
+		Entry &entry{resources[handle.slot]};
+		if (entry.resident) {
+			++hits;
+		} else {
+			++misses;
+			++reloads;
+			make_resident(entry);
+		}
+		lru.splice(lru.end(), lru, entry.lru_position);
+		enforce_budgets(&entry);
+		return entry.view;
+	}
+
+	template<ResourceType T>
+	void ResourceController<T>::set_cpu_budget(const std::size_t budget)
+	{
+		cpu_budget = budget;
+		enforce_budgets(nullptr);
+	}
+
+	template<ResourceType T>
+	void ResourceController<T>::set_gpu_budget(const std::size_t budget)
+	{
+		gpu_budget = budget;
+		enforce_budgets(nullptr);
+	}
+
+	template<ResourceType T>
+	std::size_t ResourceController<T>::get_cpu_usage() const
+	{
+		return cpu_usage;
+	}
+
+	template<ResourceType T>
+	std::size_t ResourceController<T>::get_gpu_usage() const
+	{
+		return gpu_usage;
+	}
 
 	template<ResourceType T>
-	const std::weak_ptr<T> ResourceController<T>::retrieve(const std::string key) const
+	bool ResourceController<T>::is_over_budget() const
 	{
-		return std::weak_ptr<T>(resources.at(key));
+		return cpu_usage > cpu_budget || gpu_usage > gpu_budget;
+	}
+
+	template<ResourceType T>
+	unsigned long ResourceController<T>::get_hit_count() const
+	{
+		return hits;
+	}
+
+	template<ResourceType T>
+	unsigned long ResourceController<T>::get_miss_count() const
+	{
+		return misses;
+	}
+
+	template<ResourceType T>
+	unsigned long ResourceController<T>::get_eviction_count() const
+	{
+		return evictions;
+	}
+
+	template<ResourceType T>
+	unsigned long ResourceController<T>::get_reload_count() const
+	{
+		return reloads;
+	}
+
+	template<ResourceType T>
+	float ResourceController<T>::get_hit_rate() const
+	{
+		if (hits + misses == 0) {
+			return 0.0F;
+		}
+		return static_cast<float>(hits) / (hits + misses);
+	}
+
+	template<ResourceType T>
+	std::size_t ResourceController<T>::KeyHash::operator()(const std::string_view key) const
+	{
+		return std::hash<std::string_view>{}(key);
+	}
+
+	template<ResourceType T>
+	void ResourceController<T>::make_resident(Entry &entry)
+	{
+		entry.resource->load(entry.path);
+		entry.resident = true;
+		entry.cpu_size = entry.resource->get_cpu_size();
+		entry.gpu_size = entry.resource->get_gpu_size();
+		cpu_usage += entry.cpu_size;
+		gpu_usage += entry.gpu_size;
+	}
+
+	template<ResourceType T>
+	void ResourceController<T>::evict(Entry &entry)
+	{
+		entry.resource->unload();
+		entry.resident = false;
+		cpu_usage -= entry.cpu_size;
+		gpu_usage -= entry.gpu_size;
+		entry.cpu_size = 0;
+		entry.gpu_size = 0;
+		++evictions;
+	}
+
+	template<ResourceType T>
+	void ResourceController<T>::enforce_budgets(const Entry *keep)
+	{
+		for (auto e{lru.begin()}; e != lru.end() && is_over_budget(); ++e) {
+			Entry &entry{**e};
+			if (&entry == keep || !entry.resident || entry.resource.use_count() > 1) {
+				continue;
+			}
+			evict(entry);
+		}
 	}
 }
@@ -11,6 +11,7 @@ namespace res
 	{
 		std::ifstream fs(path, std::ios::ate);
 		const long size{fs.tellg()};
+		this->size = size + 1;
 		fs.seekg(0);
 		text = new char[size + 1];
 		for (long int c{0}; c < size; ++c) {
@@ -22,7 +23,19 @@ namespace res
 
 	void TextResource::unload()
 	{
-		delete text;
+		delete[] text;
+		text = nullptr;
+		size = 0;
+	}
+
+	std::size_t TextResource::get_cpu_size() const
+	{
+		return size;
+	}
+
+	std::size_t TextResource::get_gpu_size() const
+	{
+		return 0;
 	}
 
 	const char *TextResource::get_text() const
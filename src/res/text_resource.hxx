@@ -10,11 +10,14 @@ namespace res
 	public:
 		virtual void load(const std::string path) override;
 		virtual void unload() override;
+		virtual std::size_t get_cpu_size() const override;
+		virtual std::size_t get_gpu_size() const override;
 
 		const char *get_text() const;
 
 	private:
-		char *text;
+		char *text{nullptr};
+		std::size_t size{0};
 	};
 }
 
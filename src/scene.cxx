@@ -1,19 +1,49 @@
 #include "scene.hxx"
 
+#include <cstring>
+#include <glbinding/gl/gl.h>
 #include <node.hxx>
 #include <camera_component.hxx>
+#include <deferred_deletion.hxx>
 
 namespace res
 {
+	namespace
+	{
+		// binding points of the Frame and Objects blocks in the shaders
+		constexpr unsigned int frame_binding{0};
+		constexpr unsigned int object_binding{1};
+
+		// std140 layout of the Frame block
+		struct FrameBlock
+		{
+			float view[16];
+			float projection[16];
+			float light_direction[4];
+		};
+
+		// std430 layout of an element of the Objects block
+		struct ObjectBlock
+		{
+			float model[16];
+			float parameters[4];
+		};
+	}
+
 	Scene::Scene()
 	{
-		root = new Node;
+		root = node_pool.allocate();
 		root->owning_scene = this;
 		view_matrix = midnight::matrixIdentity<4>();
 		const midnight::Matrix4x4 default_p{midnight::matrixPerspective(0.57, 800 / 600, 0.001F, 2000)};
 		projection_matrix = default_p;
 	}
 
+	Scene::~Scene()
+	{
+		release_node(root);
+	}
+
 	Node *Scene::get_root()
 	{
 		return root;
@@ -24,8 +54,139 @@ namespace res
 		return active_camera;
 	}
 
+	void Scene::set_light_direction(const midnight::Vector3 light_direction)
+	{
+		this->light_direction = light_direction;
+	}
+
 	void Scene::cycle()
 	{
+		RenderSnapshot &snapshot{get_update_snapshot()};
+		// clear keeps the capacity, so a steady scene doesn't allocate packets every frame
+		snapshot.packets.clear();
+		snapshot.models.clear();
+		if (active_camera != nullptr) {
+			active_camera->update_scene_view_matrix();
+		}
+		view_frustum = Frustum{projection_matrix * view_matrix};
 		root->cycle();
+		snapshot.view_matrix = view_matrix;
+		snapshot.projection_matrix = projection_matrix;
+		snapshot.light_direction = light_direction;
+	}
+
+	void Scene::render()
+	{
+		const RenderSnapshot &snapshot{snapshots[1 - update_snapshot]};
+		const std::size_t objects_size{snapshot.packets.size() * sizeof(ObjectBlock)};
+		streaming.begin_frame(sizeof(FrameBlock) + objects_size, 2);
+
+		FrameBlock frame;
+		std::memcpy(frame.view, snapshot.view_matrix.dataPtr(), sizeof(frame.view));
+		std::memcpy(frame.projection, snapshot.projection_matrix.dataPtr(), sizeof(frame.projection));
+		std::memcpy(frame.light_direction, snapshot.light_direction.dataPtr(), 3 * sizeof(float));
+		frame.light_direction[3] = 0.0F;
+		const std::size_t frame_offset{streaming.write(&frame, sizeof(FrameBlock))};
+		gl::glBindBufferRange(gl::GL_UNIFORM_BUFFER, frame_binding, streaming.get_buffer(), frame_offset, sizeof(FrameBlock));
+
+		if (!snapshot.packets.empty()) {
+			// written straight into the mapping, draws find theirs through gl_BaseInstance
+			const StreamingBuffer::Allocation objects{streaming.allocate(objects_size)};
+			for (std::size_t i{0}; i < snapshot.packets.size(); ++i) {
+				ObjectBlock object;
+				std::memcpy(object.model, snapshot.packets[i].model.dataPtr(), sizeof(object.model));
+				std::memcpy(object.parameters, snapshot.packets[i].parameters, sizeof(object.parameters));
+				std::memcpy(objects.data + i * sizeof(ObjectBlock), &object, sizeof(ObjectBlock));
+			}
+			gl::glBindBufferRange(gl::GL_SHADER_STORAGE_BUFFER, object_binding, streaming.get_buffer(), objects.offset, objects_size);
+		}
+
+		unsigned int shader{0};
+		for (unsigned int i{0}; i < snapshot.packets.size(); ++i) {
+			const DrawPacket &packet{snapshot.packets[i]};
+			if (packet.shader != shader) {
+				shader = packet.shader;
+				gl::glUseProgram(shader);
+			}
+			gl::glBindVertexArray(packet.vao);
+			gl::glDrawElementsInstancedBaseInstance(
+					gl::GL_TRIANGLES,
+					packet.index_count,
+					packet.index_type,
+					reinterpret_cast<void*>(0),
+					1,
+					i
+					);
+		}
+		gl::glBindVertexArray(0);
+		streaming.end_frame();
+	}
+
+	void Scene::swap_snapshots()
+	{
+		update_snapshot = 1 - update_snapshot;
+		// counts the models in view as used, and reloads any evicted before they were locked
+		for (const ModelUse &use : snapshots[1 - update_snapshot].models) {
+			use.controller->retrieve(use.handle);
+		}
+		collect_deferred_deletions();
+	}
+
+	std::vector<Node*> Scene::query_aabb(const Aabb &bounds) const
+	{
+		return bvh.query_aabb(bounds);
+	}
+
+	std::vector<Node*> Scene::query_sphere(const midnight::Vector3 centre, const float radius) const
+	{
+		return bvh.query_sphere(centre, radius);
+	}
+
+	std::vector<Node*> Scene::query_frustum(const midnight::Matrix4x4 &view_projection) const
+	{
+		return bvh.query_frustum(view_projection);
+	}
+
+	std::vector<Node*> Scene::query_view() const
+	{
+		return bvh.query_frustum(projection_matrix * view_matrix);
+	}
+
+	std::optional<RayHit> Scene::ray_cast(
+			const midnight::Vector3 origin,
+			const midnight::Vector3 direction,
+			const float max_distance
+			) const
+	{
+		return bvh.ray_cast(origin, direction, max_distance);
+	}
+
+	void Scene::release_component(Component *component)
+	{
+		if (component == active_camera) {
+			active_camera = nullptr;
+		}
+		component_pools[component->type_id]->release(component);
+	}
+
+	RenderSnapshot &Scene::get_update_snapshot()
+	{
+		return snapshots[update_snapshot];
+	}
+
+	void Scene::release_node(Node *node)
+	{
+		for (Node *child{node->first_child}; child != nullptr;) {
+			// read before the child goes back to the pool
+			Node *const next{child->next_sibling};
+			release_node(child);
+			child = next;
+		}
+		for (Component *component{node->first_component}; component != nullptr;) {
+			Component *const next{component->next_component};
+			release_component(component);
+			component = next;
+		}
+		node_pool.release(node);
 	}
 }
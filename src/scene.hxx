@@ -1,31 +1,109 @@
 #ifndef RES_Scene
 #define RES_Scene
 
+#include <vector>
+#include <memory>
+#include <optional>
 #include <matrix.hxx>
+#include <component.hxx>
+#include <pool.hxx>
+#include <bvh.hxx>
+#include <snapshot.hxx>
+#include <streaming_buffer.hxx>
 
 namespace res
 {
 	class Node;
 	class Camera;
 
+	// Owns every node and component in it. They come from the scene's pools and are all released
+	// when the scene is destroyed.
+	//
+	// A frame is split in two: cycle updates the scene and records what to draw into a snapshot,
+	// render submits the snapshot recorded by the cycle before the last swap_snapshots. The two
+	// touch separate snapshots, so cycle can run on another thread while render runs on the GL
+	// thread. Nodes, components and resources must not be changed while cycle runs, and the spatial
+	// queries must not be made then either, since drawables move their bounds in the tree as they
+	// cycle. Between cycle returning and the next one starting, both are fine from any one thread.
+	//
+	// A snapshot is rendered a frame after it was recorded and names GL objects directly, so those
+	// objects must outlive it. Meshes get this by deferring their deletion, and swap_snapshots
+	// deletes what no snapshot can name anymore. It has to be called on the GL thread, once per
+	// frame after render and while cycle isn't running, since it also retrieves the models in view
+	// again, which can load and evict models.
+	//
+	// Render streams the camera, light and every draw's model matrix and parameters through a
+	// persistently mapped buffer, shaders read them from the Frame block at binding 0 and the
+	// Objects block at binding 1, indexed by gl_BaseInstance.
 	class Scene final
 	{
 	public:
 		Scene();
+		Scene(const Scene &other) = delete;
+		~Scene();
+
+		void operator=(const Scene &other) = delete;
 
 		Node *get_root();
 		Camera const *get_active_camera() const;
+		void set_light_direction(const midnight::Vector3 light_direction);
 		void cycle();
+		void render();
+		void swap_snapshots();
+
+		// Spatial queries over drawables, their bounds are refitted as the scene cycles. They see
+		// the bounds from the last cycle and must not overlap a running one.
+		std::vector<Node*> query_aabb(const Aabb &bounds) const;
+		std::vector<Node*> query_sphere(const midnight::Vector3 centre, const float radius) const;
+		std::vector<Node*> query_frustum(const midnight::Matrix4x4 &view_projection) const;
+		std::vector<Node*> query_view() const;
+		std::optional<RayHit> ray_cast(
+				const midnight::Vector3 origin,
+				const midnight::Vector3 direction,
+				const float max_distance = std::numeric_limits<float>::max()
+				) const;
 	
 	private:
 		Node *root{nullptr};
 		Camera *active_camera{nullptr};
 		midnight::Matrix4x4 view_matrix;
 		midnight::Matrix4x4 projection_matrix;
+		midnight::Vector3 light_direction{0, 1, 0};
+		// of the view being cycled, drawables outside it are neither drawn nor kept loaded
+		Frustum view_frustum;
+		Bvh bvh;
+		RenderSnapshot snapshots[2];
+		unsigned int update_snapshot{0};
+		// frame and per-draw data for the shaders, only the render pass touches it
+		StreamingBuffer streaming;
+		Pool<Node> node_pool;
+		// indexed by component_id
+		std::vector<std::unique_ptr<PoolBase<Component>>> component_pools;
+
+		template<ComponentType T>
+		T *allocate_component();
+		void release_component(Component *component);
+		void release_node(Node *node);
+		RenderSnapshot &get_update_snapshot();
 
+		friend class Node;
 		friend class Camera;
 		friend class Drawable;
+		friend class Water;
 	};
+
+	template<ComponentType T>
+	T *Scene::allocate_component()
+	{
+		const unsigned int id{component_id<T>()};
+		if (id >= component_pools.size()) {
+			component_pools.resize(id + 1);
+		}
+		if (!component_pools[id]) {
+			component_pools[id] = std::make_unique<Pool<T, Component>>();
+		}
+		return static_cast<Pool<T, Component>*>(component_pools[id].get())->allocate();
+	}
 }
 
 #endif
@@ -1,16 +1,32 @@
 #version 460 core
 
 layout (location = 0) in vec3 i_vertex;
-layout (location = 1) in vec3 i_normal;
+layout (location = 1) in vec4 i_normal;
 
-uniform mat4 u_model;
-uniform mat4 u_view;
-uniform mat4 u_projection;
+layout (std140, binding = 0) uniform Frame
+{
+	mat4 u_view;
+	mat4 u_projection;
+	vec4 u_light_dir;
+};
+
+struct Object
+{
+	mat4 model;
+	// meaning is up to the shader
+	vec4 parameters;
+};
+
+layout (std430, binding = 1) readonly buffer Objects
+{
+	Object u_objects[];
+};
 
 out vec3 ov_normal;
 
 void main()
 {
-	ov_normal = i_normal;
-	gl_Position = u_projection * u_view * u_model * vec4(i_vertex.xyz, 1.0F);
+	ov_normal = i_normal.xyz;
+	const mat4 model = u_objects[gl_BaseInstance].model;
+	gl_Position = u_projection * u_view * model * vec4(i_vertex.xyz, 1.0F);
 }
@@ -0,0 +1,61 @@
+#version 460 core
+
+layout (location = 0) in vec3 i_vertex;
+
+layout (std140, binding = 0) uniform Frame
+{
+	mat4 u_view;
+	mat4 u_projection;
+	vec4 u_light_dir;
+};
+
+struct Object
+{
+	mat4 model;
+	// xy is the centre of the patch's level, z the level's half extent and w the time
+	vec4 parameters;
+};
+
+layout (std430, binding = 1) readonly buffer Objects
+{
+	Object u_objects[];
+};
+
+out vec3 ov_normal;
+
+const int wave_count = 4;
+// xy is the direction, z the wavelength and w the amplitude
+const vec4 waves[wave_count] = vec4[](
+	vec4(1.0F, 0.0F, 37.0F, 0.12F),
+	vec4(0.6F, 0.8F, 19.0F, 0.07F),
+	vec4(-0.7F, 0.7F, 9.0F, 0.04F),
+	vec4(0.2F, -1.0F, 4.0F, 0.02F)
+);
+
+void main()
+{
+	const Object object = u_objects[gl_BaseInstance];
+	vec4 world = object.model * vec4(i_vertex.x, 0.0F, i_vertex.z, 1.0F);
+	const float cell = object.model[0][0];
+
+	// towards the outer edge of a level, odd vertices slide onto the next level's grid so that
+	// the two levels meet without cracks
+	const vec2 from_centre = abs(world.xz - object.parameters.xy) / object.parameters.z;
+	const float morph = clamp((max(from_centre.x, from_centre.y) - 0.75F) / 0.2F, 0.0F, 1.0F);
+	const vec2 cells = round(world.xz / cell);
+	const vec2 odd = cells - 2.0F * floor(cells * 0.5F);
+	world.xz -= odd * cell * morph;
+
+	float height = 0.0F;
+	vec2 slope = vec2(0.0F);
+	for (int i = 0; i < wave_count; ++i) {
+		const float k = 6.2831853F / waves[i].z;
+		const float phase = k * dot(waves[i].xy, world.xz) + sqrt(9.81F * k) * object.parameters.w;
+		height += waves[i].w * sin(phase);
+		slope += waves[i].w * k * cos(phase) * waves[i].xy;
+	}
+	world.y += height;
+
+	ov_normal = normalize(vec3(-slope.x, 1.0F, -slope.y));
+	gl_Position = u_projection * u_view * world;
+}
@@ -0,0 +1,44 @@
+#ifndef RES_SNAPSHOT
+#define RES_SNAPSHOT
+
+#include <vector>
+#include <memory>
+#include <glbinding/gl/types.h>
+#include <matrix.hxx>
+#include <resource.hxx>
+#include <model_resource.hxx>
+
+namespace res
+{
+	// Everything the render phase needs to submit one draw, copied out of the scene during update.
+	struct DrawPacket final
+	{
+		unsigned int shader{0};
+		unsigned int vao{0};
+		unsigned int index_count{0};
+		gl::GLenum index_type;
+		midnight::Matrix4x4 model;
+		// passed through as the draw's parameters in the Objects block, meaning is up to the shader
+		float parameters[4]{0.0F, 0.0F, 0.0F, 0.0F};
+	};
+
+	// A model the packets draw from. Holding it keeps it from being evicted while the snapshot
+	// names its vertex arrays, and it is retrieved again through controller once recorded.
+	struct ModelUse final
+	{
+		ResourceController<ModelResource> *controller{nullptr};
+		ResourceHandle<ModelResource> handle;
+		std::shared_ptr<ModelResource> model;
+	};
+
+	struct RenderSnapshot final
+	{
+		midnight::Matrix4x4 view_matrix;
+		midnight::Matrix4x4 projection_matrix;
+		midnight::Vector3 light_direction;
+		std::vector<DrawPacket> packets;
+		std::vector<ModelUse> models;
+	};
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include "streaming_buffer.hxx"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <glbinding/gl/gl.h>
+
+namespace res
+{
+	namespace
+	{
+		constexpr gl::GLuint64 wait_timeout{1000000};
+	}
+
+	StreamingBuffer::~StreamingBuffer()
+	{
+		release();
+	}
+
+	void StreamingBuffer::begin_frame(const std::size_t size, const unsigned int write_count)
+	{
+		if (alignment == 0) {
+			int uniform_alignment{1}, storage_alignment{1};
+			gl::glGetIntegerv(gl::GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+			gl::glGetIntegerv(gl::GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+			alignment = static_cast<std::size_t>(std::max({uniform_alignment, storage_alignment, 1}));
+		}
+
+		const std::size_t required{size + write_count * (alignment - 1)};
+		if (required > region_size) {
+			reallocate(std::max(required, region_size * 2));
+		}
+
+		region = (region + 1) % region_count;
+		cursor = 0;
+		if (fences[region] != nullptr) {
+			gl::GLenum result{gl::glClientWaitSync(fences[region], gl::GL_SYNC_FLUSH_COMMANDS_BIT, wait_timeout)};
+			while (result == gl::GL_TIMEOUT_EXPIRED) {
+				result = gl::glClientWaitSync(fences[region], gl::GL_SYNC_FLUSH_COMMANDS_BIT, wait_timeout);
+			}
+			if (result == gl::GL_WAIT_FAILED) {
+				std::cerr << "Streaming buffer, waiting for a region failed.\n";
+			}
+			gl::glDeleteSync(fences[region]);
+			fences[region] = nullptr;
+		}
+	}
+
+	StreamingBuffer::Allocation StreamingBuffer::allocate(const std::size_t size)
+	{
+		const std::size_t begin{(cursor + alignment - 1) / alignment * alignment};
+		assert(begin + size <= region_size);
+		cursor = begin + size;
+		const std::size_t offset{region * region_size + begin};
+		return {offset, mapping + offset};
+	}
+
+	std::size_t StreamingBuffer::write(const void *data, const std::size_t size)
+	{
+		const Allocation allocation{allocate(size)};
+		std::memcpy(allocation.data, data, size);
+		return allocation.offset;
+	}
+
+	void StreamingBuffer::end_frame()
+	{
+		fences[region] = gl::glFenceSync(gl::GL_SYNC_GPU_COMMANDS_COMPLETE, gl::GL_NONE_BIT);
+	}
+
+	unsigned int StreamingBuffer::get_buffer() const
+	{
+		return buffer;
+	}
+
+	void StreamingBuffer::reallocate(const std::size_t region_size)
+	{
+		// the old storage stays alive until draws still reading it are done, so nothing waits here
+		release();
+		// regions start aligned so that offsets into them can be bound
+		this->region_size = (region_size + alignment - 1) / alignment * alignment;
+		const std::size_t size{this->region_size * region_count};
+		const auto flags{gl::GL_MAP_WRITE_BIT | gl::GL_MAP_PERSISTENT_BIT | gl::GL_MAP_COHERENT_BIT};
+		gl::glCreateBuffers(1, &buffer);
+		gl::glNamedBufferStorage(buffer, size, nullptr, flags);
+		mapping = static_cast<std::byte*>(gl::glMapNamedBufferRange(buffer, 0, size, flags));
+	}
+
+	void StreamingBuffer::release()
+	{
+		for (gl::GLsync &fence : fences) {
+			if (fence != nullptr) {
+				gl::glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+		if (buffer != 0) {
+			gl::glUnmapNamedBuffer(buffer);
+			gl::glDeleteBuffers(1, &buffer);
+			buffer = 0;
+			mapping = nullptr;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef RES_STREAMING_BUFFER
+#define RES_STREAMING_BUFFER
+
+#include <cstddef>
+#include <glbinding/gl/types.h>
+
+namespace res
+{
+	// Persistently mapped buffer for data that changes every frame. It is split into region_count
+	// regions which frames write in turn, and each region is fenced once its frame is submitted, so
+	// writing only waits if the GPU is still region_count frames behind.
+	//
+	// Storage is made on the first begin_frame and grown there when a frame asks for more, so a GL
+	// context has to be current by then.
+	class StreamingBuffer final
+	{
+	public:
+		static constexpr unsigned int region_count{3};
+
+		struct Allocation
+		{
+			// from the start of the buffer, for binding
+			std::size_t offset;
+			std::byte *data;
+		};
+
+		StreamingBuffer() = default;
+		StreamingBuffer(const StreamingBuffer &other) = delete;
+		~StreamingBuffer();
+
+		StreamingBuffer &operator=(const StreamingBuffer &other) = delete;
+
+		// Moves on to the next region, waiting for its fence, and makes sure it has room for
+		// write_count writes of size bytes in total.
+		void begin_frame(const std::size_t size, const unsigned int write_count);
+		// Reserves size bytes of the current region aligned for uniform and shader storage binding.
+		Allocation allocate(const std::size_t size);
+		// Copies size bytes into the current region and returns their offset.
+		std::size_t write(const void *data, const std::size_t size);
+		// Fences the current region after everything submitted so far.
+		void end_frame();
+		unsigned int get_buffer() const;
+
+	private:
+		unsigned int buffer{0};
+		std::byte *mapping{nullptr};
+		std::size_t region_size{0};
+		std::size_t alignment{0};
+		gl::GLsync fences[region_count]{};
+		unsigned int region{0};
+		std::size_t cursor{0};
+
+		void reallocate(const std::size_t region_size);
+		void release();
+	};
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+#include <bvh.hxx>
+
+namespace
+{
+	constexpr unsigned int box_count{2000};
+
+	// the tree never dereferences its nodes, so ids stand in for them
+	res::Node *as_node(const unsigned int id)
+	{
+		return reinterpret_cast<res::Node*>(static_cast<std::uintptr_t>(id + 1));
+	}
+
+	std::set<res::Node*> as_set(const std::vector<res::Node*> &nodes)
+	{
+		return std::set<res::Node*>(nodes.begin(), nodes.end());
+	}
+
+	bool check(const bool condition, const char *what)
+	{
+		if (!condition) {
+			std::cerr << "Failed: " << what << '\n';
+		}
+		return condition;
+	}
+}
+
+// Churns the tree with random inserts, moves and removes, which exercises the rotations and the
+// free list, and checks every query against a brute force scan of the same boxes.
+int main()
+{
+	std::mt19937 random{7};
+	std::uniform_real_distribution<float> coordinate{-100.0F, 100.0F};
+	std::uniform_real_distribution<float> extent{0.1F, 5.0F};
+	const auto random_box{[&] {
+		const float x{coordinate(random)}, y{coordinate(random)}, z{coordinate(random)}, size{extent(random)};
+		res::Aabb box;
+		box.expand(x, y, z);
+		box.expand(x + size, y + size, z + size);
+		return box;
+	}};
+
+	res::Bvh bvh;
+	std::vector<res::Aabb> boxes(box_count);
+	std::vector<unsigned int> proxies(box_count, res::Bvh::null_proxy);
+	for (unsigned int i{0}; i < box_count; ++i) {
+		boxes[i] = random_box();
+		proxies[i] = bvh.insert(boxes[i], as_node(i));
+	}
+	for (unsigned int step{0}; step < 20000; ++step) {
+		const unsigned int i{static_cast<unsigned int>(random() % box_count)};
+		switch (random() % 3) {
+		case 0:
+			if (proxies[i] != res::Bvh::null_proxy) {
+				bvh.remove(proxies[i]);
+				proxies[i] = res::Bvh::null_proxy;
+			} else {
+				boxes[i] = random_box();
+				proxies[i] = bvh.insert(boxes[i], as_node(i));
+			}
+			break;
+		default:
+			if (proxies[i] != res::Bvh::null_proxy) {
+				const float offset{coordinate(random) * 0.05F};
+				for (unsigned int k{0}; k < 3; ++k) {
+					boxes[i].min[k] += offset;
+					boxes[i].max[k] += offset;
+				}
+				bvh.move(proxies[i], boxes[i]);
+			}
+			break;
+		}
+	}
+
+	bool passed{true};
+	const std::size_t live{static_cast<std::size_t>(std::count_if(proxies.begin(), proxies.end(), [](const unsigned int proxy) {
+		return proxy != res::Bvh::null_proxy;
+	}))};
+	passed &= check(bvh.get_proxy_count() == live, "the proxy count follows inserts and removes");
+
+	unsigned int aabb_mismatches{0}, sphere_mismatches{0}, ray_mismatches{0};
+	for (unsigned int query{0}; query < 300; ++query) {
+		const res::Aabb region{random_box()};
+		const float centre[3]{coordinate(random), coordinate(random), coordinate(random)};
+		const float radius{extent(random) * 4};
+		const float direction[3]{coordinate(random), coordinate(random), coordinate(random)};
+		const float length{std::hypot(direction[0], direction[1], direction[2])};
+
+		std::set<res::Node*> overlapping, in_sphere;
+		float nearest{std::numeric_limits<float>::max()};
+		for (unsigned int i{0}; i < box_count; ++i) {
+			if (proxies[i] == res::Bvh::null_proxy) {
+				continue;
+			}
+			if (boxes[i].overlaps(region)) {
+				overlapping.insert(as_node(i));
+			}
+			float squared_distance{0.0F};
+			float enter{0.0F}, leave{std::numeric_limits<float>::max()};
+			for (unsigned int k{0}; k < 3; ++k) {
+				const float gap{std::max({boxes[i].min[k] - centre[k], 0.0F, centre[k] - boxes[i].max[k]})};
+				squared_distance += gap * gap;
+				const float scale{length / direction[k]};
+				const float a{(boxes[i].min[k] - centre[k]) * scale}, b{(boxes[i].max[k] - centre[k]) * scale};
+				enter = std::max(enter, std::min(a, b));
+				leave = std::min(leave, std::max(a, b));
+			}
+			if (squared_distance <= radius * radius) {
+				in_sphere.insert(as_node(i));
+			}
+			if (enter <= leave) {
+				nearest = std::min(nearest, enter);
+			}
+		}
+
+		aabb_mismatches += as_set(bvh.query_aabb(region)) != overlapping;
+		sphere_mismatches += as_set(bvh.query_sphere(midnight::Vector3{centre[0], centre[1], centre[2]}, radius)) != in_sphere;
+		const std::optional<res::RayHit> hit{bvh.ray_cast(
+				midnight::Vector3{centre[0], centre[1], centre[2]},
+				midnight::Vector3{direction[0], direction[1], direction[2]}
+				)};
+		if (nearest == std::numeric_limits<float>::max()) {
+			ray_mismatches += hit.has_value();
+		} else {
+			ray_mismatches += !hit.has_value() || std::abs(hit->distance - nearest) > 1e-3F;
+		}
+	}
+	passed &= check(aabb_mismatches == 0, "query_aabb matches a brute force scan");
+	passed &= check(sphere_mismatches == 0, "query_sphere matches a brute force scan");
+	passed &= check(ray_mismatches == 0, "ray_cast finds the nearest box a brute force scan finds");
+
+	for (unsigned int i{0}; i < box_count; ++i) {
+		if (proxies[i] != res::Bvh::null_proxy) {
+			bvh.remove(proxies[i]);
+		}
+	}
+	passed &= check(bvh.get_proxy_count() == 0, "removing every proxy empties the tree");
+	passed &= check(bvh.query_aabb(random_box()).empty(), "an empty tree finds nothing");
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
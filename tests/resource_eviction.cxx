@@ -0,0 +1,83 @@
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <resource.hxx>
+
+namespace
+{
+	class SizedResource final : public res::Resource
+	{
+	public:
+		virtual void load(const std::string path) override
+		{
+			size = 100;
+		}
+
+		virtual void unload() override
+		{
+			size = 0;
+		}
+
+		virtual std::size_t get_cpu_size() const override
+		{
+			return size;
+		}
+
+		virtual std::size_t get_gpu_size() const override
+		{
+			return 0;
+		}
+
+	private:
+		std::size_t size{0};
+	};
+
+	bool check(const bool condition, const char *what)
+	{
+		if (!condition) {
+			std::cerr << "Failed: " << what << '\n';
+		}
+		return condition;
+	}
+}
+
+// A snapshot keeps the models it draws locked until it is recorded again, so they must not be
+// evicted from under it while the budget is enforced against other resources, and the controller
+// has to say when the locked ones alone are over the budget.
+int main()
+{
+	res::ResourceController<SizedResource> controller;
+	controller.set_cpu_budget(250);
+	const res::ResourceHandle<SizedResource> a{controller.index("a", "a")};
+	const res::ResourceHandle<SizedResource> b{controller.index("b", "b")};
+	const res::ResourceHandle<SizedResource> c{controller.index("c", "c")};
+
+	std::shared_ptr<SizedResource> drawn{controller.retrieve(a).lock()};
+	controller.retrieve(b);
+	controller.retrieve(c);
+
+	bool passed{true};
+	passed &= check(drawn->get_cpu_size() == 100, "a locked resource stays loaded while it is the least recently retrieved");
+	passed &= check(controller.get_cpu_usage() <= 250, "the budget is met by evicting unlocked resources");
+
+	const std::weak_ptr<SizedResource> view{controller.retrieve(a)};
+	drawn.reset();
+	controller.retrieve(b);
+	controller.retrieve(c);
+	passed &= check(view.lock()->get_cpu_size() == 0, "a resource is evictable once nobody holds it locked");
+	passed &= check(controller.retrieve(a).lock()->get_cpu_size() == 100, "retrieving an evicted resource reloads it");
+	passed &= check(controller.get_cpu_usage() <= 250, "the budget holds after reloading");
+	passed &= check(!controller.is_over_budget(), "a met budget isn't reported as over");
+
+	std::shared_ptr<SizedResource> drawn_a{controller.retrieve(a).lock()};
+	std::shared_ptr<SizedResource> drawn_b{controller.retrieve(b).lock()};
+	controller.set_cpu_budget(150);
+	passed &= check(controller.is_over_budget(), "locked resources keeping usage over the budget are reported");
+	drawn_a.reset();
+	drawn_b.reset();
+	controller.retrieve(c);
+	passed &= check(!controller.is_over_budget(), "the budget is met again once the resources are released");
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}